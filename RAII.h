@@ -20,8 +20,15 @@ void RAII_set_deleter(void* target_, void(*deleter)(void* target_));
 //  maybe be caused by the lack of ownership
 void RAII_set_dummy_deleter(void* target_);
 
+// destroy a RAII embedded object by calling its custom deleter, without freeing the space it occupies
+//  this is for objects not allocated on their own, like those embedded in another object or an array
+void RAII_destroy(void* target_);
+
 // delete a RAII embedded object by first calling its custom deleter
 //  and then free the space this object itself occupies
+// The space is released by Memory_release, not free, so that the object must have been allocated by
+//  Memory_allocate_object or the allocator set by Memory_set_allocator. Objects from malloc are only
+//  fine while the allocator is Allocator_system, and objects of the library must never be passed to free
 // Generate a warning in debugging mode for RAII embedded objects whose
 //  deleter is not set
 void RAII_delete(void* target_);
@@ -0,0 +1,138 @@
+#include "arena.h"
+#include "RAII.h"
+#include "chunk.h"
+#include "memory.h"
+#include "standard_fix.h"
+#include <stdalign.h>
+#include <stddef.h>
+#include <string.h>
+enum Arena_Constant{
+    Arena_Alignment = 16,               // alignment of every allocation
+    Arena_LargeSize = Chunk_Size / 4,   // allocations larger than this take blocks of chunks of their own
+};
+// header at start of each block of chunks taken by arena
+typedef struct ArenaChunk_{
+    alignas(Arena_Alignment) struct ArenaChunk_* next;
+    size_t size;
+}ArenaChunk_;
+// header before each block given out by Arena_allocate_block, recording its size
+typedef struct{
+    alignas(Arena_Alignment) size_t size;
+}ArenaBlock_;
+// object registered to be destroyed with arena
+typedef struct ArenaFinalizer_{
+    struct ArenaFinalizer_* next;
+    void* object;
+}ArenaFinalizer_;
+struct Arena{
+    RAII _;
+    ChunkOwner owner_;
+    // free part of the latest chunk
+    char* cursor_;
+    char* end_;
+    ArenaChunk_* chunks_;
+    ArenaFinalizer_* finalizers_;
+};
+static _Thread_local Arena* Arena_current_ = NULL;
+
+// memory of single objects is reclaimed with the arena
+static void Arena_release_(Unused ChunkOwner* owner, Unused void* object){}
+
+// resize a block by moving it to a new one, the old block is reclaimed with the arena
+static void* Arena_reallocate_(ChunkOwner* owner, void* block, size_t size){
+    Arena* arena = (Arena*)((char*)owner - offsetof(Arena, owner_));
+    const size_t old_size = ((ArenaBlock_*)block - 1)->size;
+    if(size <= old_size){
+        ((ArenaBlock_*)block - 1)->size = size;
+        return block;
+    }
+    void* resized = Arena_allocate_block(arena, size);
+    if(resized != NULL) memcpy(resized, block, old_size);
+    return resized;
+}
+
+// take a block of chunks for arena, recording it to be released with arena
+//  return start of memory after header
+static char* Arena_take_chunks_(Arena* arena, size_t size){
+    ArenaChunk_* chunk = (ArenaChunk_*)Chunk_allocate(&arena->owner_, size);
+    if(chunk == NULL) return NULL;
+    chunk->next = arena->chunks_;
+    chunk->size = size;
+    arena->chunks_ = chunk;
+    return (char*)(chunk + 1);
+}
+
+// destroy the arena, destroying registered objects and releasing all memory
+static void Arena_destroy_(Arena* arena){
+    for(ArenaFinalizer_* finalizer = arena->finalizers_; finalizer != NULL; finalizer = finalizer->next){
+        RAII_destroy(finalizer->object);
+    }
+    while(arena->chunks_ != NULL){
+        ArenaChunk_* next = arena->chunks_->next;
+        Chunk_release(arena->chunks_, arena->chunks_->size);
+        arena->chunks_ = next;
+    }
+    if(Arena_current_ == arena) Arena_current_ = NULL;
+}
+
+Arena* Arena_create(void){
+    return Arena_create_with(NULL);
+}
+
+Arena* Arena_create_with(const Allocator* allocator){
+    // the arena itself must not come from the arena in scope, which may be deleted first
+    Arena* previous = Arena_enter(NULL);
+    Arena* arena = (Arena*)Memory_allocate_object(sizeof(Arena));
+    Arena_leave(previous);
+    arena->owner_.release = Arena_release_;
+    arena->owner_.reallocate = Arena_reallocate_;
+    arena->owner_.allocator = allocator;
+    arena->cursor_ = arena->end_ = NULL;
+    arena->chunks_ = NULL;
+    arena->finalizers_ = NULL;
+    RAII_set_deleter(arena, (void(*)(void*))Arena_destroy_);
+    return arena;
+}
+
+void* Arena_allocate(Arena* arena, size_t size){
+    size = (size + Arena_Alignment - 1) & ~(size_t)(Arena_Alignment - 1);
+    if(size > Arena_LargeSize) return Arena_take_chunks_(arena, sizeof(ArenaChunk_) + size);
+    if((size_t)(arena->end_ - arena->cursor_) < size){
+        // the rest of the current chunk is abandoned, which wastes at most Arena_LargeSize bytes
+        char* start = Arena_take_chunks_(arena, Chunk_Size);
+        if(start == NULL) return NULL;
+        arena->cursor_ = start;
+        arena->end_ = (char*)arena->chunks_ + Chunk_Size;
+    }
+    void* result = arena->cursor_;
+    arena->cursor_ += size;
+    return result;
+}
+
+void* Arena_allocate_block(Arena* arena, size_t size){
+    ArenaBlock_* block = (ArenaBlock_*)Arena_allocate(arena, sizeof(ArenaBlock_) + size);
+    if(block == NULL) return NULL;
+    block->size = size;
+    return block + 1;
+}
+
+void Arena_own(Arena* arena, void* object){
+    ArenaFinalizer_* finalizer = (ArenaFinalizer_*)Arena_allocate(arena, sizeof(ArenaFinalizer_));
+    finalizer->object = object;
+    finalizer->next = arena->finalizers_;
+    arena->finalizers_ = finalizer;
+}
+
+Arena* Arena_enter(Arena* arena){
+    Arena* previous = Arena_current_;
+    Arena_current_ = arena;
+    return previous;
+}
+
+void Arena_leave(Arena* previous){
+    Arena_current_ = previous;
+}
+
+Arena* Arena_current(void){
+    return Arena_current_;
+}
\ No newline at end of file
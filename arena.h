@@ -0,0 +1,44 @@
+#ifndef CxKANOAXDP_arena_H_
+#define CxKANOAXDP_arena_H_
+#include "memory.h"
+#include <stddef.h>
+// region of memory objects are carved out of one after another, and which is returned to the system at once
+//  while a thread is in the scope of an arena, all objects and arrays the library allocates for it come from
+//   the arena, including nodes, entries and containers themselves. Deleting the arena releases all of them
+//   in time proportional to the memory taken rather than the number of objects, without walking containers
+//  releasing a single object of an arena only runs its deleter, the memory is reclaimed with the arena
+//  objects holding resources beyond memory, such as files, may be registered with Arena_own to have their
+//   deleters run when the arena is deleted
+//  an arena shall be used by one thread at a time
+typedef struct Arena Arena;
+
+// create a new arena, which is deleted with RAII_delete
+Arena* Arena_create(void);
+
+// create a new arena whose memory comes from allocator, NULL for the allocator of the library
+//  everything created in scope of the arena is thus placed in memory from allocator
+Arena* Arena_create_with(const Allocator* allocator);
+
+// allocate memory of specified size from arena, aligned for any object
+//  return NULL if out of memory
+void* Arena_allocate(Arena* arena, size_t size);
+
+// allocate a block of specified size from arena, which can be resized by Memory_reallocate
+//  return NULL if out of memory
+void* Arena_allocate_block(Arena* arena, size_t size);
+
+// register a RAII object to be destroyed when arena is deleted, in reverse order of registering
+//  the object must not be deleted otherwise. It need not be allocated from the arena
+void Arena_own(Arena* arena, void* object);
+
+// enter scope of arena on calling thread, so that the library allocates from the arena until leaving it
+//  scopes may be nested, arena may be NULL to allocate from the system within the scope
+//  return the arena in scope before, which shall be passed to Arena_leave
+Arena* Arena_enter(Arena* arena);
+
+// leave scope of an arena, returning to the scope of arena returned by the matching Arena_enter
+void Arena_leave(Arena* previous);
+
+// get the arena in scope on calling thread, NULL if none
+Arena* Arena_current(void);
+#endif
\ No newline at end of file
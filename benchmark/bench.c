@@ -0,0 +1,172 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bench.h"
+#include "memory.h"
+#include "profile.h"
+#include "standard_fix.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+static size_t Bench_allocations_ = 0;
+
+uint64_t BenchRandom_next(BenchRandom* random){
+    uint64_t z = (random->state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint64_t BenchRandom_below(BenchRandom* random, uint64_t bound){
+    // bias of modulo is negligible for bounds far below 2^64
+    return BenchRandom_next(random) % bound;
+}
+
+// helpers of rejection-inversion keeping precision near 0, as in Hormann and Derflinger
+static double BenchZipf_helper1_(double x){
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - x / 4));
+}
+
+static double BenchZipf_helper2_(double x){
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x / 2 * (1 + x / 3 * (1 + x / 4));
+}
+
+static double BenchZipf_h_(const BenchZipf* zipf, double x){
+    return exp(-zipf->exponent * log(x));
+}
+
+static double BenchZipf_integral_(const BenchZipf* zipf, double x){
+    const double log_x = log(x);
+    return BenchZipf_helper2_((1 - zipf->exponent) * log_x) * log_x;
+}
+
+static double BenchZipf_integral_inverse_(const BenchZipf* zipf, double x){
+    double t = x * (1 - zipf->exponent);
+    if(t < -1) t = -1;
+    return exp(BenchZipf_helper1_(t) * x);
+}
+
+static void BenchZipf_initialize_(BenchZipf* zipf, uint64_t n, double exponent){
+    zipf->exponent = exponent;
+    zipf->n = (double)n;
+    zipf->integral_x1 = BenchZipf_integral_(zipf, 1.5) - 1;
+    zipf->integral_n = BenchZipf_integral_(zipf, zipf->n + 0.5);
+    zipf->s = 2 - BenchZipf_integral_inverse_(zipf, BenchZipf_integral_(zipf, 2.5) - BenchZipf_h_(zipf, 2));
+}
+
+// draw a rank from 1 to n
+static uint64_t BenchZipf_next_(const BenchZipf* zipf, BenchRandom* random){
+    while(true){
+        const double uniform = (BenchRandom_next(random) >> 11) * 0x1.0p-53;
+        const double u = zipf->integral_n + uniform * (zipf->integral_x1 - zipf->integral_n);
+        const double x = BenchZipf_integral_inverse_(zipf, u);
+        double k = floor(x + 0.5);
+        if(k < 1) k = 1;
+        else if(k > zipf->n) k = zipf->n;
+        if(k - x <= zipf->s || u >= BenchZipf_integral_(zipf, k + 0.5) - BenchZipf_h_(zipf, k)) return (uint64_t)k;
+    }
+}
+
+uint64_t Bench_key(uint64_t rank){
+    // an odd multiplier modulo 2^64 is a bijection, the top bit is set so that no key is 0
+    return (rank * 0x9E3779B97F4A7C15ull) | (1ull << 63);
+}
+
+void BenchKeySource_initialize(BenchKeySource* source, enum BenchKeys distribution, uint64_t bound, uint64_t seed){
+    source->distribution = distribution;
+    source->bound = bound == 0 ? 1 : bound;
+    source->random.state = seed;
+    if(distribution == BenchKeys_Zipf) BenchZipf_initialize_(&source->zipf, source->bound, 0.99);
+}
+
+uint64_t BenchKeySource_next(BenchKeySource* source){
+    if(source->distribution == BenchKeys_Zipf) return Bench_key(BenchZipf_next_(&source->zipf, &source->random) - 1);
+    return Bench_key(BenchRandom_below(&source->random, source->bound));
+}
+
+double Bench_now(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void BenchPhase_begin(BenchPhase* phase, const char* name){
+    *phase = (BenchPhase){.phase = name};
+}
+
+void BenchPhase_record(BenchPhase* phase, double started, size_t operations){
+    const double elapsed = Bench_now() - started;
+    if(phase->batches == phase->capacity){
+        phase->capacity = phase->capacity == 0 ? 1024 : phase->capacity << 1;
+        phase->latencies = (double*)realloc(phase->latencies, sizeof(double) * phase->capacity);
+    }
+    phase->latencies[phase->batches++] = elapsed / operations;
+    phase->operations += operations;
+    phase->elapsed += elapsed;
+}
+
+static int Bench_compare_doubles_(const void* lhs_, const void* rhs_){
+    const double lhs = *(const double*)lhs_, rhs = *(const double*)rhs_;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+// get a percentile of sorted latencies in nanoseconds
+static double BenchPhase_percentile_(const BenchPhase* phase, double percentile){
+    if(phase->batches == 0) return 0;
+    size_t index = (size_t)(percentile / 100 * phase->batches);
+    if(index >= phase->batches) index = phase->batches - 1;
+    return phase->latencies[index] * 1e9;
+}
+
+void BenchPhase_end(BenchPhase* phase, const char* label){
+    qsort(phase->latencies, phase->batches, sizeof(double), Bench_compare_doubles_);
+    printf(
+        "[Benchmark]: %s %s: %zu ops, %.3f Mops/s, p50 %.1f ns, p99 %.1f ns, p99.9 %.1f ns\n",
+        label, phase->phase, phase->operations,
+        phase->elapsed > 0 ? phase->operations / phase->elapsed / 1e6 : 0.0,
+        BenchPhase_percentile_(phase, 50), BenchPhase_percentile_(phase, 99), BenchPhase_percentile_(phase, 99.9)
+    );
+    free(phase->latencies);
+    phase->latencies = NULL;
+}
+
+void Bench_count_allocation(void){
+    Bench_allocations_ += 1;
+}
+
+static void* Bench_allocate_(Unused void* context, size_t size, size_t alignment){
+    Bench_allocations_ += 1;
+    return Allocator_system.allocate(Allocator_system.context, size, alignment);
+}
+
+static void* Bench_reallocate_(Unused void* context, void* block, size_t size){
+    Bench_allocations_ += 1;
+    return Allocator_system.reallocate(Allocator_system.context, block, size);
+}
+
+static void Bench_release_(Unused void* context, void* block){
+    Allocator_system.release(Allocator_system.context, block);
+}
+
+static const Allocator Bench_allocator_ = {
+    .allocate = Bench_allocate_,
+    .reallocate = Bench_reallocate_,
+    .release = Bench_release_,
+    .context = NULL,
+};
+
+void Bench_install_allocator(void){
+    Memory_set_allocator(&Bench_allocator_);
+}
+
+void Bench_report_memory(const char* label){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("[Benchmark]: %s: peak RSS %ld KiB, system allocations %zu", label, usage.ru_maxrss, Bench_allocations_);
+    #if BASE_PROFILING
+    ProfileSnapshot snapshot;
+    Profile_snapshot(&snapshot);
+    printf(", library allocations %zu, library peak %zu bytes", snapshot.total.allocations, snapshot.total.peak_bytes);
+    #endif
+    printf("\n");
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef CxKANOAXDP_bench_H_
+#define CxKANOAXDP_bench_H_
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+// harness of benchmarks: key streams, timing of operations in batches and reporting
+//  operations are timed a batch at a time, with keys of each batch drawn before its clock starts, so that
+//   drawing keys is not measured. Latency percentiles are those of the mean latency within batches
+enum Bench_Constant{
+    Bench_Batch = 128,  // operations timed together
+};
+// distribution of keys drawn
+enum BenchKeys{
+    BenchKeys_Uniform,
+    // ranks follow Zipf's law with exponent 0.99, the ranks are scrambled so that hot keys are scattered
+    BenchKeys_Zipf,
+};
+
+// splitmix64 generator
+typedef struct{
+    uint64_t state;
+}BenchRandom;
+
+// sampler of Zipf distribution over ranks 1 to n, by rejection-inversion in constant time per sample
+typedef struct{
+    double exponent;
+    double n;
+    double integral_x1;
+    double integral_n;
+    double s;
+}BenchZipf;
+
+// source of keys, which are scrambled ranks below a bound
+typedef struct{
+    enum BenchKeys distribution;
+    uint64_t bound;
+    BenchRandom random;
+    BenchZipf zipf;
+}BenchKeySource;
+
+// latencies of batches and operation count of a phase of benchmark
+typedef struct{
+    const char* phase;
+    size_t operations;
+    double* latencies;
+    size_t batches;
+    size_t capacity;
+    double started;
+    double elapsed;
+}BenchPhase;
+
+uint64_t BenchRandom_next(BenchRandom* random);
+
+// get a random number below bound
+uint64_t BenchRandom_below(BenchRandom* random, uint64_t bound);
+
+void BenchKeySource_initialize(BenchKeySource* source, enum BenchKeys distribution, uint64_t bound, uint64_t seed);
+
+// draw a key, which is never 0 so that it may stand for a non-NULL pointer
+uint64_t BenchKeySource_next(BenchKeySource* source);
+
+// get a scrambled key of a rank, which is a bijection
+uint64_t Bench_key(uint64_t rank);
+
+// get monotonic time in seconds
+double Bench_now(void);
+
+void BenchPhase_begin(BenchPhase* phase, const char* name);
+
+// time a batch from started to now, which performed specified number of operations
+void BenchPhase_record(BenchPhase* phase, double started, size_t operations);
+
+// print throughput and latency percentiles of a phase, and release it
+void BenchPhase_end(BenchPhase* phase, const char* label);
+
+// count an allocation reaching the system, with baSe through its allocator, and with references directly
+void Bench_count_allocation(void);
+
+// install the counting allocator for baSe
+void Bench_install_allocator(void);
+
+// print peak resident set size and counts of allocations
+void Bench_report_memory(const char* label);
+#endif
\ No newline at end of file
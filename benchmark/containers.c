@@ -0,0 +1,304 @@
+// benchmark of containers of baSe against plain references on synthetic workloads
+//  usage: bench_containers <vector|heap|hashtable|list> <base|reference> <uniform|zipf> <size>
+//  each run measures one container and implementation in a process of its own, so that peak RSS is its own
+#include "bench.h"
+#include "RAII.h"
+#include "hash.h"
+#include "hashtable.h"
+#include "heap.h"
+#include "list.h"
+#include "vector.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+enum BenchContainers_Constant{
+    BenchContainers_ListVisits = 200000000,     // nodes visited by finds on lists of all sizes, bounding their time
+    BenchContainers_MinFinds = 16,
+};
+// parameters of a run
+typedef struct{
+    const char* label;
+    enum BenchKeys distribution;
+    size_t size;
+}BenchRun_;
+
+// run phase operations a batch at a time, drawing keys of each batch before timing it
+//  operate is given the batch of keys and the index of first operation in phase
+#define BenchContainers_phase_(run, name, operations, source, operate)                                      \
+    do{                                                                                                     \
+        BenchPhase phase_;                                                                                  \
+        BenchPhase_begin(&phase_, name);                                                                    \
+        uint64_t keys[Bench_Batch];                                                                         \
+        for(size_t first = 0; first < (operations); first += Bench_Batch){                                  \
+            const size_t count = (operations) - first < Bench_Batch ? (operations) - first : Bench_Batch;    \
+            for(size_t i = 0; i < count; i++) keys[i] = BenchKeySource_next(source);                        \
+            const double started = Bench_now();                                                             \
+            for(size_t i = 0; i < count; i++){ operate; }                                                   \
+            BenchPhase_record(&phase_, started, count);                                                     \
+        }                                                                                                   \
+        (void)keys;                                                                                         \
+        BenchPhase_end(&phase_, (run)->label);                                                              \
+    }while(0)
+
+// comparator of keys stored as pointers
+static int BenchContainers_compare_(const void* lhs_, const void* rhs_){
+    return (uintptr_t)lhs_ < (uintptr_t)rhs_ ? -1 : (uintptr_t)lhs_ > (uintptr_t)rhs_;
+}
+
+static uint64_t BenchContainers_hash_(const void* key){
+    return Hash_mix64((uint64_t)(uintptr_t)key);
+}
+
+// reference allocation, counted in the same way as those of baSe reaching the system
+static void* BenchContainers_reallocate_(void* block, size_t size){
+    Bench_count_allocation();
+    return realloc(block, size);
+}
+
+// append N keys, then read N elements at indexes drawn as keys
+static void BenchContainers_vector_(const BenchRun_* run, bool reference){
+    BenchKeySource source;
+    BenchKeySource_initialize(&source, run->distribution, run->size, 1);
+    volatile uintptr_t sink = 0;
+    if(reference){
+        uintptr_t* data = NULL;
+        size_t size = 0, capacity = 0;
+        BenchContainers_phase_(run, "emplace_back", run->size, &source, {
+            if(size == capacity){
+                capacity = capacity == 0 ? 16 : capacity << 1;
+                data = (uintptr_t*)BenchContainers_reallocate_(data, sizeof(uintptr_t) * capacity);
+            }
+            data[size++] = keys[i];
+        });
+        BenchContainers_phase_(run, "at", run->size, &source, {
+            sink += data[keys[i] % size];
+        });
+        free(data);
+    }else{
+        Vector* vector = Vector_create();
+        BenchContainers_phase_(run, "emplace_back", run->size, &source, {
+            Vector_emplace_back(vector, (void*)(uintptr_t)keys[i], false);
+        });
+        BenchContainers_phase_(run, "at", run->size, &source, {
+            sink += (uintptr_t)Vector_at(vector, keys[i] % run->size);
+        });
+        RAII_delete(vector);
+    }
+}
+
+// reference binary heap of keys
+typedef struct{
+    uint64_t* data;
+    size_t size;
+    size_t capacity;
+}BenchHeap_;
+
+static void BenchHeap_insert_(BenchHeap_* heap, uint64_t key){
+    if(heap->size == heap->capacity){
+        heap->capacity = heap->capacity == 0 ? 16 : heap->capacity << 1;
+        heap->data = (uint64_t*)BenchContainers_reallocate_(heap->data, sizeof(uint64_t) * heap->capacity);
+    }
+    size_t index = heap->size++;
+    while(index > 0 && key < heap->data[(index - 1) >> 1]){
+        heap->data[index] = heap->data[(index - 1) >> 1];
+        index = (index - 1) >> 1;
+    }
+    heap->data[index] = key;
+}
+
+static void BenchHeap_pop_(BenchHeap_* heap){
+    const uint64_t key = heap->data[--heap->size];
+    size_t index = 0;
+    while(true){
+        size_t child = (index << 1) + 1;
+        if(child >= heap->size) break;
+        if(child + 1 < heap->size && heap->data[child + 1] < heap->data[child]) child += 1;
+        if(key <= heap->data[child]) break;
+        heap->data[index] = heap->data[child];
+        index = child;
+    }
+    if(heap->size != 0) heap->data[index] = key;
+}
+
+// insert N keys, then pop all of them
+static void BenchContainers_heap_(const BenchRun_* run, bool reference){
+    BenchKeySource source;
+    BenchKeySource_initialize(&source, run->distribution, run->size, 1);
+    if(reference){
+        BenchHeap_ heap = {0};
+        BenchContainers_phase_(run, "insert", run->size, &source, BenchHeap_insert_(&heap, keys[i]));
+        BenchContainers_phase_(run, "pop", run->size, &source, BenchHeap_pop_(&heap));
+        free(heap.data);
+    }else{
+        Heap* heap = Heap_create(BenchContainers_compare_);
+        BenchContainers_phase_(run, "insert", run->size, &source, {
+            Heap_insert(heap, (void*)(uintptr_t)keys[i], false, NULL, false);
+        });
+        BenchContainers_phase_(run, "pop", run->size, &source, Heap_pop(heap));
+        RAII_delete(heap);
+    }
+}
+
+// reference hash set with open addressing and linear probing, 0 marks empty slots
+typedef struct{
+    uint64_t* slots;
+    size_t capacity;
+    size_t size;
+}BenchHashSet_;
+
+static size_t BenchHashSet_find_(const BenchHashSet_* set, uint64_t key){
+    size_t slot = Hash_mix64(key) & (set->capacity - 1);
+    while(set->slots[slot] != 0 && set->slots[slot] != key) slot = (slot + 1) & (set->capacity - 1);
+    return slot;
+}
+
+static void BenchHashSet_insert_(BenchHashSet_* set, uint64_t key){
+    if((set->size + 1) * 4 > set->capacity * 3){
+        BenchHashSet_ grown = {.capacity = set->capacity == 0 ? 16 : set->capacity << 1};
+        Bench_count_allocation();
+        grown.slots = (uint64_t*)calloc(grown.capacity, sizeof(uint64_t));
+        for(size_t i = 0; i < set->capacity; i++){
+            if(set->slots[i] != 0) grown.slots[BenchHashSet_find_(&grown, set->slots[i])] = set->slots[i];
+        }
+        grown.size = set->size;
+        free(set->slots);
+        *set = grown;
+    }
+    const size_t slot = BenchHashSet_find_(set, key);
+    if(set->slots[slot] == 0) set->size += 1;
+    set->slots[slot] = key;
+}
+
+static void BenchHashSet_erase_(BenchHashSet_* set, uint64_t key){
+    if(set->capacity == 0) return;
+    size_t hole = BenchHashSet_find_(set, key);
+    if(set->slots[hole] == 0) return;
+    const size_t mask = set->capacity - 1;
+    for(size_t next = (hole + 1) & mask; set->slots[next] != 0; next = (next + 1) & mask){
+        const size_t home = Hash_mix64(set->slots[next]) & mask;
+        if(((next - home) & mask) >= ((next - hole) & mask)){
+            set->slots[hole] = set->slots[next];
+            hole = next;
+        }
+    }
+    set->slots[hole] = 0;
+    set->size -= 1;
+}
+
+// insert N keys, then N operations of 80% lookups, 10% inserts and 10% erases over twice as many keys
+static void BenchContainers_hashtable_(const BenchRun_* run, bool reference){
+    BenchKeySource inserted, mixed;
+    BenchKeySource_initialize(&inserted, BenchKeys_Uniform, run->size, 1);
+    BenchKeySource_initialize(&mixed, run->distribution, run->size * 2, 2);
+    BenchRandom random = {.state = 3};
+    volatile size_t hits = 0;
+    if(reference){
+        BenchHashSet_ set = {0};
+        BenchContainers_phase_(run, "insert", run->size, &inserted, BenchHashSet_insert_(&set, keys[i]));
+        BenchContainers_phase_(run, "find", run->size, &mixed, {
+            hits += set.slots[BenchHashSet_find_(&set, keys[i])] != 0;
+        });
+        BenchContainers_phase_(run, "mix", run->size, &mixed, {
+            const uint64_t dice = BenchRandom_below(&random, 10);
+            if(dice == 0) BenchHashSet_insert_(&set, keys[i]);
+            else if(dice == 1) BenchHashSet_erase_(&set, keys[i]);
+            else hits += set.slots[BenchHashSet_find_(&set, keys[i])] != 0;
+        });
+        free(set.slots);
+    }else{
+        HashTable table;
+        HashTable_initialize64(&table, 1, BenchContainers_hash_, BenchContainers_compare_);
+        BenchContainers_phase_(run, "insert", run->size, &inserted, {
+            HashTable_insert(&table, (void*)(uintptr_t)keys[i], false, NULL, false, NULL);
+        });
+        BenchContainers_phase_(run, "find", run->size, &mixed, {
+            hits += HashTable_find(&table, (void*)(uintptr_t)keys[i]) != NULL;
+        });
+        BenchContainers_phase_(run, "mix", run->size, &mixed, {
+            const uint64_t dice = BenchRandom_below(&random, 10);
+            if(dice == 0){
+                HashTable_insert(&table, (void*)(uintptr_t)keys[i], false, NULL, false, NULL);
+            }else if(dice == 1){
+                KeyValue* entry = HashTable_find(&table, (void*)(uintptr_t)keys[i]);
+                if(entry != NULL) HashTable_erase_entry(&table, entry);
+            }else{
+                hits += HashTable_find(&table, (void*)(uintptr_t)keys[i]) != NULL;
+            }
+        });
+        RAII_destroy(&table);
+    }
+}
+
+// put N keys at both ends alternately, then find keys by linear search, fewer for longer lists
+static void BenchContainers_list_(const BenchRun_* run, bool reference){
+    BenchKeySource source, found;
+    BenchKeySource_initialize(&source, BenchKeys_Uniform, run->size, 1);
+    BenchKeySource_initialize(&found, run->distribution, run->size, 1);
+    size_t finds = BenchContainers_ListVisits / (run->size == 0 ? 1 : run->size);
+    if(finds < BenchContainers_MinFinds) finds = BenchContainers_MinFinds;
+    volatile size_t hits = 0;
+    if(reference){
+        // a deque in an array, filled from its middle outwards
+        uint64_t* data = NULL;
+        Bench_count_allocation();
+        data = (uint64_t*)malloc(sizeof(uint64_t) * (run->size * 2 + 1));
+        size_t front = run->size, back = run->size;
+        BenchContainers_phase_(run, "emplace", run->size, &source, {
+            if((first + i) & 1) data[back++] = keys[i];
+            else data[--front] = keys[i];
+        });
+        BenchContainers_phase_(run, "find", finds, &found, {
+            for(size_t j = front; j < back; j++){
+                if(data[j] == keys[i]){
+                    hits += 1;
+                    break;
+                }
+            }
+        });
+        free(data);
+    }else{
+        List* list = List_create();
+        BenchContainers_phase_(run, "emplace", run->size, &source, {
+            ListNode* node = ListNode_create((void*)(uintptr_t)keys[i], false);
+            if((first + i) & 1) List_emplace_back(list, node);
+            else List_emplace_front(list, node);
+        });
+        BenchContainers_phase_(run, "find", finds, &found, {
+            hits += List_find(list, (void*)(uintptr_t)keys[i], NULL) != NULL;
+        });
+        RAII_delete(list);
+    }
+}
+
+int main(int argc, char** argv){
+    static const struct{
+        const char* name;
+        void (*run)(const BenchRun_* run, bool reference);
+    }containers[] = {
+        {"vector", BenchContainers_vector_},
+        {"heap", BenchContainers_heap_},
+        {"hashtable", BenchContainers_hashtable_},
+        {"list", BenchContainers_list_},
+    };
+    if(argc != 5){
+        fprintf(stderr, "usage: %s <vector|heap|hashtable|list> <base|reference> <uniform|zipf> <size>\n", argv[0]);
+        return 2;
+    }
+    const bool reference = strcmp(argv[2], "reference") == 0;
+    char label[128];
+    snprintf(label, sizeof(label), "%s %s %s %s", argv[1], argv[2], argv[3], argv[4]);
+    const BenchRun_ run = {
+        .label = label,
+        .distribution = strcmp(argv[3], "zipf") == 0 ? BenchKeys_Zipf : BenchKeys_Uniform,
+        .size = strtoull(argv[4], NULL, 10),
+    };
+    Bench_install_allocator();
+    for(size_t i = 0; i < sizeof(containers) / sizeof(containers[0]); i++){
+        if(strcmp(argv[1], containers[i].name) != 0) continue;
+        containers[i].run(&run, reference);
+        Bench_report_memory(label);
+        return 0;
+    }
+    fprintf(stderr, "[Benchmark]: unknown container %s\n", argv[1]);
+    return 2;
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "RAII.h"
 #include "bitio.h"
+#include "memory.h"
+#include "profile.h"
 #include <stdio.h>
 #include <limits.h>
 #include <assert.h>
@@ -207,7 +209,8 @@ static inline void BitIO_initialize_(BitIO* io){
 }
 
 BitIO* BitIO_create(){
-    BitIO* io = (BitIO*)malloc(sizeof(BitIO));
+    Profile_allocating_(ProfileKind_BitIO);
+    BitIO* io = (BitIO*)Memory_allocate_object(sizeof(BitIO));
     BitIO_initialize_(io);
     return io;
 }
@@ -239,7 +242,19 @@ static bool BitIO_pull_BitIO_(BitIO* io){
     if(read_size == BitIO_BufferSize){
         io->size_.read.bits_read = BitIO_BufferSize * CHAR_BIT;
     }else{
-        io->size_.read.bits_read = CHAR_BIT * read_size + io->buffer_[BitIO_BufferRedundancy + read_size - 1];
+        // the size indicator tells 1 to CHAR_BIT bits effective, anything else is left by a corrupted or
+        //  truncated file, in which case nothing more is read
+        const unsigned int indicator = io->buffer_[BitIO_BufferRedundancy + read_size - 1];
+        if(indicator == 0 || indicator > CHAR_BIT){
+            #ifndef NDEBUG
+            fprintf(stderr, "[BitIO]: Corrupted size indicator in BitIO stream!\n");
+            #endif
+            io->size_.read.eof = true;
+            io->size_.read.bits_read = 0;
+            io->size_.read.bits_available = 0;
+            return false;
+        }
+        io->size_.read.bits_read = CHAR_BIT * read_size + indicator;
     }
     io->current_byte_ = io->buffer_;
     io->size_.read.bits_available = io->size_.read.bits_read > CHAR_BIT ? CHAR_BIT : io->size_.read.bits_read;
@@ -383,10 +398,13 @@ bool BitIO_open(BitIO* io, void* source, unsigned int modes){
                     // initialize the reading buffer and counters, refer to comment on stream pulling method
                     //  for more information about the procedure above
                     read_size = fread(io->buffer_ + BitIO_BufferSize, 1, BitIO_BufferRedundancy, io->stream_);
-                    assert(read_size != 0);
-                    if(read_size == 1){
-                        assert(io->buffer_[BitIO_BufferSize] == CHAR_BIT);
-                        assert(feof(io->stream_));
+                    if(read_size == 0 || (read_size == 1 && io->buffer_[BitIO_BufferSize] != CHAR_BIT)){
+                        // a BitIO file ends with its size indicator, which is CHAR_BIT if nothing precedes it
+                        #ifndef NDEBUG
+                        fprintf(stderr, "[BitIO]: Corrupted BitIO stream to read!\n");
+                        #endif
+                        BitIO_close(io);
+                        return false;
                     }
                     io->size_.read.bits_read = 0;
                     io->size_.read.bits_available = 0;
@@ -464,7 +482,8 @@ void BitIO_write(BitIO* io, const unsigned char* bits, unsigned int bit_length){
         // copy the full bytes part of bits
         BitIO_writeBuffer_(io, bits, byte_length);
         // then handle the rest part which has no more than a single byte
-        *io->current_byte_ = bits[byte_length] >> (CHAR_BIT - bits_left);
+        //  which must not be looked at if no bit is left, as it may lie past the end of bits
+        *io->current_byte_ = bits_left == 0 ? 0 : bits[byte_length] >> (CHAR_BIT - bits_left);
         io->size_.write.bits_written = bits_left;
         return;
     }
@@ -509,7 +528,7 @@ static size_t BitIO_readBuffer_(BitIO* io, unsigned char* data, unsigned int len
     size_t bits_read = 0;
     while(length){
         // if the buffer is currently empty, pull bytes from underlying stream
-        if(io->size_.read.bits_available == 0){
+        if(io->size_.read.bits_read == 0){
             if(!io->streamOperation_(io)){
                 // no data can be pulled, stop reading
                 break;
@@ -535,6 +554,8 @@ static size_t BitIO_readBuffer_(BitIO* io, unsigned char* data, unsigned int len
         data += bytes_read;
         bits_read += actual_bits_read;
     }
+    // current byte is the one after those read, which has no bit left if buffer is used up
+    io->size_.read.bits_available = io->size_.read.bits_read > CHAR_BIT ? CHAR_BIT : io->size_.read.bits_read;
     return bits_read;
 }
 
@@ -586,29 +607,35 @@ size_t BitIO_read(BitIO* io, unsigned char* bits, unsigned int bit_length){
         bit_length = bits_left;
     }
     unsigned char helper;
-    const unsigned char bits_available = io->size_.read.bits_available;
-    const unsigned char padding_bits = CHAR_BIT - bits_available;
     while(bit_length){
+        // bits left in current byte differ from those at the beginning once a byte short of bits is reached
+        const unsigned char bits_available = io->size_.read.bits_available;
+        const unsigned char padding_bits = CHAR_BIT - bits_available;
         if(bit_length <= io->size_.read.bits_available){
             // there is enough bits in current byte
             io->size_.read.bits_available -= bit_length;
             io->size_.read.bits_read -= bit_length;
             *bits = *io->current_byte_;
             *io->current_byte_ <<= bit_length;
+            bits_read += bit_length;
             bit_length = 0;
         }else{
             // number of bits in current byte is not enough
             //  bits in current byte will be consumed in either case
             helper = *io->current_byte_;
+            // bits left in current byte are consumed before advancing, so that advancing pulls once they were
+            //  the last bits in buffer
+            io->size_.read.bits_read -= bits_available;
             if(BitIO_advanceReadBufferPointer_(io) == false){
                 // no enough bits read and end of underlying stream have been reached
                 *bits = helper;
                 bits_read += bits_available;
+                io->size_.read.bits_available = 0;
                 break;
             }
             helper = (helper & (((unsigned char)-1) << padding_bits))
                      | (*io->current_byte_ >> bits_available);
-            *bits = helper;
+            *bits++ = helper;
             const unsigned char effective_bits_in_helper = io->size_.read.bits_available >= padding_bits
                                                            ? CHAR_BIT
                                                            : bits_available + io->size_.read.bits_available;
@@ -618,9 +645,64 @@ size_t BitIO_read(BitIO* io, unsigned char* bits, unsigned int bit_length){
             bits_read += actual_bits_read;
             bit_length -= actual_bits_read;
             *io->current_byte_ <<= current_byte_consumed_bits;
-            io->size_.read.bits_read -= actual_bits_read;
+            io->size_.read.bits_read -= current_byte_consumed_bits;
             io->size_.read.bits_available -= current_byte_consumed_bits;
+            // a byte holding less than a full byte of bits can only be the last one in stream, the helper stored
+            //  is then partial and bits are no longer aligned to the destination, stop before writing past it
+            if(actual_bits_read < CHAR_BIT && bit_length) break;
         }
     }
     return bits_read;
+}
+
+enum BitIOVarint_Constant{
+    BitIOVarint_GroupBits = 7,  // value bits in a group of varint
+    BitIOVarint_MaxGroups = 10, // groups a 64-bit value takes at most
+};
+
+void BitIO_write_uint(BitIO* io, uint64_t value, unsigned int width){
+    assert(width <= 64);
+    unsigned char bytes[sizeof(uint64_t)];
+    if(width == 0) return;
+    value <<= 64 - width;
+    for(unsigned int i = 0; i < sizeof(uint64_t); i++) bytes[i] = (unsigned char)(value >> (56 - 8 * i));
+    BitIO_write(io, bytes, width);
+}
+
+bool BitIO_read_uint(BitIO* io, uint64_t* value, unsigned int width){
+    assert(width <= 64);
+    unsigned char bytes[sizeof(uint64_t)] = {0};
+    if(width == 0){
+        *value = 0;
+        return true;
+    }
+    if(BitIO_read(io, bytes, width) != width) return false;
+    uint64_t result = 0;
+    for(unsigned int i = 0; i < sizeof(uint64_t); i++) result = (result << 8) | bytes[i];
+    *value = result >> (64 - width);
+    return true;
+}
+
+void BitIO_write_varint(BitIO* io, uint64_t value){
+    while(true){
+        const uint64_t group = value & ((1u << BitIOVarint_GroupBits) - 1);
+        value >>= BitIOVarint_GroupBits;
+        BitIO_write_uint(io, (uint64_t)(value != 0) << BitIOVarint_GroupBits | group, BitIOVarint_GroupBits + 1);
+        if(value == 0) return;
+    }
+}
+
+bool BitIO_read_varint(BitIO* io, uint64_t* value){
+    uint64_t result = 0;
+    for(unsigned int i = 0; i < BitIOVarint_MaxGroups; i++){
+        uint64_t group;
+        if(!BitIO_read_uint(io, &group, BitIOVarint_GroupBits + 1)) return false;
+        result |= (group & ((1u << BitIOVarint_GroupBits) - 1)) << (BitIOVarint_GroupBits * i);
+        if((group >> BitIOVarint_GroupBits) == 0){
+            *value = result;
+            return true;
+        }
+    }
+    // too many groups for a 64-bit value, the stream is corrupted
+    return false;
 }
\ No newline at end of file
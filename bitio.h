@@ -2,6 +2,7 @@
 #define CxKANOAXDP_bitio_H_
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 // open requests of BitIO
 enum BitIOOpen: unsigned int{
     // open BitIO for read
@@ -69,4 +70,19 @@ unsigned char BitIO_get(BitIO* io);
 // read multiple bits from output, the bits will be stored from most significant bit to least significant bit
 //  return number of bits actually read
 size_t BitIO_read(BitIO* io, unsigned char* bits, unsigned int bit_length);
+
+// write the lowest width bits of value, from the most significant to the least, width shall not exceed 64
+void BitIO_write_uint(BitIO* io, uint64_t value, unsigned int width);
+
+// read width bits written by BitIO_write_uint into value
+//  return if all bits are read, otherwise value is left as is
+bool BitIO_read_uint(BitIO* io, uint64_t* value, unsigned int width);
+
+// write value as a varint, which takes groups of 7 bits from the least significant, each preceded by a bit
+//  telling if another group follows, so that small values take few bits
+void BitIO_write_varint(BitIO* io, uint64_t value);
+
+// read a varint written by BitIO_write_varint into value
+//  return if a complete varint is read, otherwise value is left as is
+bool BitIO_read_varint(BitIO* io, uint64_t* value);
 #endif
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef CxKANOAXDP_bitops_H_
+#define CxKANOAXDP_bitops_H_
+#include <stdint.h>
+// helpers for inspecting bits of integers, mapped to compiler builtins where available
+
+// compile a function twice, with and without the POPCNT instruction, and pick one when the library is loaded
+//  by what the processor supports, so that BitOps_popcount inlined into the function takes a single instruction
+//  even though the library is built without -mpopcnt
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__GLIBC__) && !defined(__POPCNT__)
+#define BitOps_PopcountClones __attribute__((target_clones("popcnt", "default")))
+#else
+#define BitOps_PopcountClones
+#endif
+
+// count leading zero bits, value must not be 0
+static inline unsigned int BitOps_leading_zeros(uint64_t value){
+    #if defined(__GNUC__)
+    return __builtin_clzll(value);
+    #else
+    unsigned int count = 0;
+    while(!(value & (UINT64_C(1) << 63))){
+        value <<= 1;
+        count += 1;
+    }
+    return count;
+    #endif
+}
+
+// count trailing zero bits, value must not be 0
+static inline unsigned int BitOps_trailing_zeros(uint64_t value){
+    #if defined(__GNUC__)
+    return __builtin_ctzll(value);
+    #else
+    unsigned int count = 0;
+    while(!(value & 1)){
+        value >>= 1;
+        count += 1;
+    }
+    return count;
+    #endif
+}
+
+// count set bits
+//  a single instruction where built for processors having POPCNT, or in functions marked BitOps_PopcountClones
+static inline unsigned int BitOps_popcount(uint64_t value){
+    #if defined(__GNUC__)
+    return __builtin_popcountll(value);
+    #else
+    value = value - ((value >> 1) & UINT64_C(0x5555555555555555));
+    value = (value & UINT64_C(0x3333333333333333)) + ((value >> 2) & UINT64_C(0x3333333333333333));
+    value = (value + (value >> 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+    return (value * UINT64_C(0x0101010101010101)) >> 56;
+    #endif
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,409 @@
+#include "bitvector.h"
+#include "RAII.h"
+#include "bitio.h"
+#include "bitops.h"
+#include "memory.h"
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(__unix__) || defined(__APPLE__)
+#define BitVector_Mmap_ 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define BitVector_Mmap_ 0
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BitVector_Avx2_ 1
+#include <immintrin.h>
+#else
+#define BitVector_Avx2_ 0
+#endif
+// [DESIGN: Rank Directory]
+//  bits are split into blocks of BitVector_BlockBits bits, each of 8 words of 64 bits. The directory holds two
+//   words for each block, aligned so that the pair of a block never straddles cache lines:
+//   1. Number of set bits before the block
+//   2. Number of set bits in the block before each of words 1 to 7, packed in 9 bits each from the lowest
+//  a rank query therefore reads the pair of its block and counts a single word of bits, touching two cache
+//   lines at most. A pair past the last block holds number of all set bits
+//  select looks up the block holding every BitVector_SelectSample-th set bit, then binary searches blocks
+//   between the samples around the rank queried by their first words in the directory, and finds the word and
+//   bit within the block by counting. Samples more than BitVector_SparseBlocks_ blocks apart would make the
+//   search long, so positions of all set bits between them are stored instead, marked by BitVector_sparse_ in
+//   the sample. There are BitVector_SelectSample positions of 64 bits for at least 8 times as many bits, which
+//   keeps them within 1/8 of the space of bits, and any search takes no more than 10 steps
+//  blocks are counted by AVX2 where the processor supports it, checked at run time since the library is built
+//   for processors in general, as POPCNT is for counting words in rank and select
+//  words are read from bytes most significant byte first regardless of byte order of the machine, so that
+//   the most significant bit of a word is the first bit within it, as BitIO lays out bits
+//  the last block may be partial and may end before the memory holding bits does, so it is copied to a
+//   block of its own padded with unset bits, and all words are read through BitVector_block_
+enum BitVector_Constant_{
+    BitVector_BlockBytes_ = BitVector_BlockBits / CHAR_BIT,
+    BitVector_BlockWords_ = BitVector_BlockBits / 64,
+    BitVector_CacheLine_ = 64,
+    BitVector_FieldBits_ = 9,       // bits of each count packed in the second word of directory pair
+    BitVector_FieldMask_ = (1 << BitVector_FieldBits_) - 1,
+    BitVector_SignatureLength_ = 5,
+    BitVector_SparseBlocks_ = 512,  // most blocks between two samples searched for select
+};
+// flag of samples followed by positions of set bits, the rest of the sample is index of the first position
+static const size_t BitVector_sparse_ = ~(SIZE_MAX >> 1);
+static const unsigned char BitVector_signature_[BitVector_SignatureLength_] = {'B', 'i', 't', 'I', 'O'};
+struct BitVector{
+    RAII _;
+    const unsigned char* bits_;
+    // memory holding bits, either mapped from a file or allocated
+    unsigned char* data_;
+    size_t length_;
+    bool mapped_;
+    size_t size_;
+    size_t count_;
+    size_t blocks_;
+    uint64_t* directory_;
+    // block holding the i-th sample of set bits, followed by the last block
+    size_t* samples_;
+    // positions of set bits between samples far apart
+    size_t* positions_;
+    unsigned char tail_[BitVector_BlockBytes_];
+};
+
+static void BitVector_destroy_(BitVector* vector){
+    #if BitVector_Mmap_
+    if(vector->mapped_){
+        if(vector->data_ != NULL) munmap(vector->data_, vector->length_);
+    }else{
+        Memory_release(vector->data_);
+    }
+    #else
+    Memory_release(vector->data_);
+    #endif
+    Memory_release(vector->directory_);
+    Memory_release(vector->samples_);
+    Memory_release(vector->positions_);
+}
+
+// read a word from bytes, most significant byte first
+static inline uint64_t BitVector_load_(const unsigned char* bytes){
+    uint64_t word = 0;
+    for(unsigned int i = 0; i < 8; i++) word = word << CHAR_BIT | bytes[i];
+    return word;
+}
+
+// get bytes of specified block
+static inline const unsigned char* BitVector_block_(const BitVector* vector, size_t block){
+    return block < vector->size_ / BitVector_BlockBits
+           ? vector->bits_ + block * BitVector_BlockBytes_ : vector->tail_;
+}
+
+// get number of set bits in block before specified word
+static inline unsigned int BitVector_before_(const BitVector* vector, size_t block, unsigned int word){
+    if(word == 0) return 0;
+    return (vector->directory_[2 * block + 1] >> (word - 1) * BitVector_FieldBits_) & BitVector_FieldMask_;
+}
+
+#if BitVector_Avx2_
+// count set bits of each word in block by AVX2
+__attribute__((target("avx2")))
+static void BitVector_count_block_avx2_(const unsigned char* block, unsigned int counts[BitVector_BlockWords_]){
+    // count bits of each nibble by lookup, then sum bytes of each word
+    const __m256i table = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+    );
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    for(unsigned int half = 0; half < 2; half++){
+        const __m256i bytes = _mm256_loadu_si256((const __m256i*)(block + half * 32));
+        const __m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(bytes, nibble));
+        const __m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble));
+        uint64_t sums[4];
+        _mm256_storeu_si256(
+            (__m256i*)sums, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256())
+        );
+        for(unsigned int i = 0; i < 4; i++) counts[half * 4 + i] = (unsigned int)sums[i];
+    }
+}
+#endif
+
+// count set bits of each word in block
+BitOps_PopcountClones
+static void BitVector_count_block_(const unsigned char* block, unsigned int counts[BitVector_BlockWords_]){
+    #if BitVector_Avx2_
+    if(__builtin_cpu_supports("avx2")){
+        BitVector_count_block_avx2_(block, counts);
+        return;
+    }
+    #endif
+    // order of bytes makes no difference to counting
+    for(unsigned int i = 0; i < BitVector_BlockWords_; i++){
+        uint64_t word;
+        memcpy(&word, block + i * 8, sizeof(word));
+        counts[i] = BitOps_popcount(word);
+    }
+}
+
+// get the block holding the set bit of specified sample
+static inline size_t BitVector_sample_block_(const BitVector* vector, size_t sample){
+    const size_t entry = vector->samples_[sample];
+    if(!(entry & BitVector_sparse_)) return entry;
+    return vector->positions_[entry & ~BitVector_sparse_] / BitVector_BlockBits;
+}
+
+// store positions of set bits between samples more than BitVector_SparseBlocks_ blocks apart, and mark them
+//  in the samples
+//  return if succeeded
+static bool BitVector_sparsify_(BitVector* vector, size_t samples){
+    size_t positions = 0;
+    for(size_t sample = 0; sample < samples; sample++){
+        if(vector->samples_[sample + 1] - vector->samples_[sample] <= BitVector_SparseBlocks_) continue;
+        const size_t end = (sample + 1) * BitVector_SelectSample;
+        positions += (end < vector->count_ ? end : vector->count_) - sample * BitVector_SelectSample;
+    }
+    if(positions == 0) return true;
+    vector->positions_ = (size_t*)Memory_allocate(sizeof(size_t) * positions);
+    if(vector->positions_ == NULL) return false;
+    size_t stored = 0;
+    for(size_t sample = 0; sample < samples; sample++){
+        // the next sample is still a block, as samples are marked in order
+        const size_t first = vector->samples_[sample], last = vector->samples_[sample + 1];
+        if(last - first <= BitVector_SparseBlocks_) continue;
+        const size_t begin = sample * BitVector_SelectSample;
+        const size_t end = begin + BitVector_SelectSample < vector->count_
+                           ? begin + BitVector_SelectSample : vector->count_;
+        vector->samples_[sample] = stored | BitVector_sparse_;
+        size_t rank = vector->directory_[2 * first];
+        for(size_t block = first; block <= last && rank < end; block++){
+            const unsigned char* bytes = BitVector_block_(vector, block);
+            for(unsigned int word = 0; word < BitVector_BlockWords_ && rank < end; word++){
+                uint64_t bits = BitVector_load_(bytes + word * 8);
+                while(bits != 0 && rank < end){
+                    const unsigned int index = BitOps_leading_zeros(bits);
+                    if(rank >= begin){
+                        vector->positions_[stored++] = block * BitVector_BlockBits + word * 64 + index;
+                    }
+                    rank += 1;
+                    bits &= ~(UINT64_C(1) << (63 - index));
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// build directory and samples of a vector whose bits are set
+//  return if succeeded
+static bool BitVector_build_(BitVector* vector){
+    const size_t full = vector->size_ / BitVector_BlockBits;
+    const size_t rest = vector->size_ % BitVector_BlockBits;
+    vector->blocks_ = full + (rest != 0);
+    memset(vector->tail_, 0, sizeof(vector->tail_));
+    if(rest != 0){
+        const size_t bytes = (rest + CHAR_BIT - 1) / CHAR_BIT;
+        memcpy(vector->tail_, vector->bits_ + full * BitVector_BlockBytes_, bytes);
+        vector->tail_[bytes - 1] &= (unsigned char)(UCHAR_MAX << (bytes * CHAR_BIT - rest));
+    }
+    size_t directory_bytes = sizeof(uint64_t) * 2 * (vector->blocks_ + 1);
+    directory_bytes = (directory_bytes + BitVector_CacheLine_ - 1) / BitVector_CacheLine_ * BitVector_CacheLine_;
+    vector->directory_ = (uint64_t*)Memory_allocate_aligned(directory_bytes, BitVector_CacheLine_);
+    if(vector->directory_ == NULL) return false;
+    size_t count = 0;
+    for(size_t block = 0; block < vector->blocks_; block++){
+        unsigned int counts[BitVector_BlockWords_];
+        BitVector_count_block_(BitVector_block_(vector, block), counts);
+        uint64_t packed = 0;
+        unsigned int before = 0;
+        for(unsigned int word = 1; word < BitVector_BlockWords_; word++){
+            before += counts[word - 1];
+            packed |= (uint64_t)before << (word - 1) * BitVector_FieldBits_;
+        }
+        vector->directory_[2 * block] = count;
+        vector->directory_[2 * block + 1] = packed;
+        count += before + counts[BitVector_BlockWords_ - 1];
+    }
+    vector->directory_[2 * vector->blocks_] = count;
+    vector->directory_[2 * vector->blocks_ + 1] = 0;
+    vector->count_ = count;
+    // a sample is taken at the block where count passes each multiple of BitVector_SelectSample
+    const size_t samples = (count + BitVector_SelectSample - 1) / BitVector_SelectSample;
+    vector->samples_ = (size_t*)Memory_allocate(sizeof(size_t) * (samples + 1));
+    if(vector->samples_ == NULL) return false;
+    size_t sample = 0;
+    for(size_t block = 0; block < vector->blocks_ && sample < samples; block++){
+        const uint64_t after = vector->directory_[2 * block + 2];
+        while(sample < samples && sample * BitVector_SelectSample < after) vector->samples_[sample++] = block;
+    }
+    vector->samples_[samples] = vector->blocks_ == 0 ? 0 : vector->blocks_ - 1;
+    return BitVector_sparsify_(vector, samples);
+}
+
+// allocate an empty vector
+static BitVector* BitVector_allocate_(void){
+    BitVector* vector = (BitVector*)Memory_allocate_object(sizeof(BitVector));
+    vector->bits_ = NULL;
+    vector->data_ = NULL;
+    vector->length_ = 0;
+    vector->mapped_ = false;
+    vector->size_ = vector->count_ = vector->blocks_ = 0;
+    vector->directory_ = NULL;
+    vector->samples_ = NULL;
+    vector->positions_ = NULL;
+    RAII_set_deleter(vector, (void(*)(void*))BitVector_destroy_);
+    return vector;
+}
+
+BitVector* BitVector_create(const void* bytes, size_t bits){
+    BitVector* vector = BitVector_allocate_();
+    const size_t length = (bits + CHAR_BIT - 1) / CHAR_BIT;
+    vector->data_ = (unsigned char*)Memory_allocate(length == 0 ? 1 : length);
+    if(vector->data_ != NULL && length != 0) memcpy(vector->data_, bytes, length);
+    vector->bits_ = vector->data_;
+    vector->length_ = length;
+    vector->size_ = bits;
+    if(vector->data_ == NULL || !BitVector_build_(vector)){
+        RAII_delete(vector);
+        return NULL;
+    }
+    return vector;
+}
+
+// bring the whole file at path into memory of vector
+//  return if succeeded
+static bool BitVector_load_file_(BitVector* vector, const char* path){
+    #if BitVector_Mmap_
+    const int descriptor = open(path, O_RDONLY);
+    if(descriptor < 0) return false;
+    struct stat status;
+    bool success = fstat(descriptor, &status) == 0;
+    if(success && status.st_size > 0){
+        vector->length_ = (size_t)status.st_size;
+        void* data = mmap(NULL, vector->length_, PROT_READ, MAP_SHARED, descriptor, 0);
+        success = data != MAP_FAILED;
+        if(success){
+            vector->data_ = (unsigned char*)data;
+            vector->mapped_ = true;
+        }
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(descriptor);
+    return success;
+    #else
+    FILE* stream = fopen(path, "rb");
+    if(stream == NULL) return false;
+    bool success = fseek(stream, 0, SEEK_END) == 0;
+    const long end = success ? ftell(stream) : -1;
+    success = end >= 0 && fseek(stream, 0, SEEK_SET) == 0;
+    if(success && end > 0){
+        vector->length_ = (size_t)end;
+        vector->data_ = (unsigned char*)Memory_allocate(vector->length_);
+        success = vector->data_ != NULL && fread(vector->data_, 1, vector->length_, stream) == vector->length_;
+    }
+    fclose(stream);
+    return success;
+    #endif
+}
+
+BitVector* BitVector_open(const char* path, unsigned int modes){
+    BitVector* vector = BitVector_allocate_();
+    if(!BitVector_load_file_(vector, path)){
+        #ifndef NDEBUG
+        fprintf(stderr, "[BitVector]: Failed to load bits from %s\n", path);
+        #endif
+        RAII_delete(vector);
+        return NULL;
+    }
+    const unsigned char* data = vector->data_;
+    const size_t length = vector->length_;
+    bool bitio = !(modes & BitIOOpen_Plain) && length > BitVector_SignatureLength_
+                 && memcmp(data, BitVector_signature_, BitVector_SignatureLength_) == 0;
+    bool valid = bitio || !(modes & BitIOOpen_BitIO);
+    if(bitio){
+        // the size indicator tells effective bits of the last byte of content, CHAR_BIT if there is none
+        const size_t content = length - BitVector_SignatureLength_ - 1;
+        const unsigned int indicator = data[length - 1];
+        valid = content == 0 ? indicator == CHAR_BIT : indicator != 0 && indicator <= CHAR_BIT;
+        vector->bits_ = data + BitVector_SignatureLength_;
+        vector->size_ = content == 0 ? 0 : (content - 1) * CHAR_BIT + indicator;
+    }else{
+        vector->bits_ = data;
+        vector->size_ = length * CHAR_BIT;
+    }
+    if(!valid){
+        #ifndef NDEBUG
+        fprintf(stderr, "[BitVector]: %s is not a valid BitIO file\n", path);
+        #endif
+        RAII_delete(vector);
+        return NULL;
+    }
+    if(!BitVector_build_(vector)){
+        RAII_delete(vector);
+        return NULL;
+    }
+    return vector;
+}
+
+size_t BitVector_size(BitVector* vector){
+    return vector->size_;
+}
+
+size_t BitVector_count(BitVector* vector){
+    return vector->count_;
+}
+
+bool BitVector_get(BitVector* vector, size_t index){
+    return (vector->bits_[index / CHAR_BIT] >> (CHAR_BIT - 1 - index % CHAR_BIT)) & 1;
+}
+
+BitOps_PopcountClones
+size_t BitVector_rank(BitVector* vector, size_t index){
+    const size_t block = index / BitVector_BlockBits;
+    const unsigned int word = index % BitVector_BlockBits / 64;
+    const unsigned int bits = index % 64;
+    size_t rank = vector->directory_[2 * block] + BitVector_before_(vector, block, word);
+    if(bits != 0){
+        const uint64_t bytes = BitVector_load_(BitVector_block_(vector, block) + word * 8);
+        rank += BitOps_popcount(bytes >> (64 - bits));
+    }
+    return rank;
+}
+
+// get index within word of set bit having rank specified, counting from the most significant bit
+static inline unsigned int BitVector_select_word_(uint64_t word, unsigned int rank){
+    unsigned int index = 0;
+    // skip whole bytes first
+    for(unsigned int count; (count = BitOps_popcount(word >> (64 - CHAR_BIT))) <= rank; word <<= CHAR_BIT){
+        rank -= count;
+        index += CHAR_BIT;
+    }
+    for(;; word <<= 1, index++){
+        if(word >> 63){
+            if(rank == 0) return index;
+            rank -= 1;
+        }
+    }
+}
+
+BitOps_PopcountClones
+size_t BitVector_select(BitVector* vector, size_t rank){
+    if(rank >= vector->count_) return vector->size_;
+    const size_t sample = vector->samples_[rank / BitVector_SelectSample];
+    if(sample & BitVector_sparse_){
+        return vector->positions_[(sample & ~BitVector_sparse_) + rank % BitVector_SelectSample];
+    }
+    // find the last block whose set bits before it are no more than rank
+    size_t low = sample;
+    size_t high = BitVector_sample_block_(vector, rank / BitVector_SelectSample + 1);
+    while(low < high){
+        const size_t middle = low + (high - low + 1) / 2;
+        if(vector->directory_[2 * middle] <= rank) low = middle;
+        else high = middle - 1;
+    }
+    const unsigned int in_block = (unsigned int)(rank - vector->directory_[2 * low]);
+    unsigned int word = 1;
+    while(word < BitVector_BlockWords_ && BitVector_before_(vector, low, word) <= in_block) word += 1;
+    word -= 1;
+    const uint64_t bits = BitVector_load_(BitVector_block_(vector, low) + word * 8);
+    return low * BitVector_BlockBits + word * 64
+           + BitVector_select_word_(bits, in_block - BitVector_before_(vector, low, word));
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef CxKANOAXDP_bitvector_H_
+#define CxKANOAXDP_bitvector_H_
+#include <stdbool.h>
+#include <stddef.h>
+// immutable sequence of bits answering rank and select queries in constant time
+//  bits are laid out as BitIO writes them, from the most significant bit of each byte to the least, so that a
+//   file written through BitIO, or any plain binary file, is mapped into memory and queried in place
+//  a directory taking 1/4 of the space of bits is built when the vector is created, along with samples of
+//   positions of set bits taking at most 1/4 of the space more
+//  a bit vector is a RAII object
+typedef struct BitVector BitVector;
+enum BitVector_Constant{
+    BitVector_BlockBits = 512,      // bits counted by each entry of the rank directory, one cache line
+    BitVector_SelectSample = 512,   // set bits between two samples of positions for select
+};
+
+// create a bit vector holding a copy of first specified number of bits from bytes
+BitVector* BitVector_create(const void* bytes, size_t bits);
+
+// open a file at path as a bit vector, which is mapped into memory where supported
+//  the mode takes BitIOOpen_Plain or BitIOOpen_BitIO from enumeration BitIOOpen, telling the file is plain
+//   or a BitIO file, and 0 to detect it by signature as BitIO does
+//  return NULL if the file cannot be opened or is not a valid BitIO file when required
+BitVector* BitVector_open(const char* path, unsigned int modes);
+
+// get number of bits in vector
+size_t BitVector_size(BitVector* vector);
+
+// get number of set bits in vector
+size_t BitVector_count(BitVector* vector);
+
+// get bit at specified index, which shall be less than size of vector
+bool BitVector_get(BitVector* vector, size_t index);
+
+// get number of set bits before specified index, which shall not be greater than size of vector
+size_t BitVector_rank(BitVector* vector, size_t index);
+
+// get index of set bit having rank specified, counting from 0
+//  return size of vector if there are no more set bits than rank
+size_t BitVector_select(BitVector* vector, size_t rank);
+#endif
\ No newline at end of file
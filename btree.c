@@ -0,0 +1,492 @@
+#include "btree.h"
+#include "RAII.h"
+#include "memory.h"
+#include "profile.h"
+#include <assert.h>
+#include <string.h>
+// [DESIGN: B+Tree Nodes]
+//  a branch of n separators has n + 1 children, and separator i is exactly the least key within child i + 1.
+//   Therefore every separator is the key of an entry in the tree, which lookups may compare against safely
+//   even if keys are deleted along with their entries. Lookups go to the child of the last separator not
+//   greater than the key
+//  inserting never lowers the least key of any subtree but the first child on each level, so separators only
+//   change when a leaf splits. Removing the least entry of a leaf replaces the separator of the first subtree
+//   up the path which is not a first child, and a node left with fewer than half of the most children or
+//   entries borrows one from a sibling, or is merged with a sibling if neither has any to spare
+//  nodes are allocated aligned to cache lines, with keys of a node in an array of their own at its start,
+//   so that binary search within a node reads as few cache lines as possible. Leaves keep keys of their
+//   entries beside the entries for the same reason
+enum BTree_Constant_{
+    BTree_MinEntries_ = BTree_Fanout / 2,   // fewest entries of a leaf other than the root
+    BTree_MinChildren_ = BTree_Fanout / 2,  // fewest children of a branch other than the root
+    BTree_MaxDepth_ = 32,                   // most branches on the path to a leaf, far more than reachable
+    BTree_CacheLine_ = 64,
+};
+typedef struct{
+    // number of entries of a leaf, or number of separators of a branch
+    unsigned int size;
+    bool leaf;
+}BTreeNode_;
+typedef struct{
+    BTreeNode_ node;
+    void* keys[BTree_Fanout - 1];
+    BTreeNode_* children[BTree_Fanout];
+}BTreeBranch_;
+typedef struct BTreeLeaf_{
+    BTreeNode_ node;
+    void* keys[BTree_Fanout];
+    KeyValue* entries[BTree_Fanout];
+    struct BTreeLeaf_* next;
+}BTreeLeaf_;
+struct BTree{
+    RAII _;
+    // NULL if tree is empty
+    BTreeNode_* root_;
+    size_t size_;
+    int (*compare_)(const void* lhs_, const void* rhs_);
+};
+// branches passed through from the root to a leaf, and index of the child taken at each of them
+typedef struct{
+    BTreeBranch_* branches[BTree_MaxDepth_];
+    unsigned int indexes[BTree_MaxDepth_];
+    unsigned int depth;
+    BTreeLeaf_* leaf;
+}BTreePath_;
+
+// allocate a node of specified size, rounded up to cache lines
+static void* BTree_node_allocate_(size_t size){
+    Profile_allocating_(ProfileKind_BTree);
+    return Memory_allocate_aligned(
+        (size + BTree_CacheLine_ - 1) / BTree_CacheLine_ * BTree_CacheLine_, BTree_CacheLine_
+    );
+}
+
+static BTreeLeaf_* BTree_leaf_create_(void){
+    BTreeLeaf_* leaf = (BTreeLeaf_*)BTree_node_allocate_(sizeof(BTreeLeaf_));
+    leaf->node.size = 0;
+    leaf->node.leaf = true;
+    leaf->next = NULL;
+    return leaf;
+}
+
+static BTreeBranch_* BTree_branch_create_(void){
+    BTreeBranch_* branch = (BTreeBranch_*)BTree_node_allocate_(sizeof(BTreeBranch_));
+    branch->node.size = 0;
+    branch->node.leaf = false;
+    return branch;
+}
+
+// release a subtree, deleting its entries
+static void BTree_release_(BTreeNode_* node){
+    if(node->leaf){
+        BTreeLeaf_* leaf = (BTreeLeaf_*)node;
+        for(unsigned int i = 0; i < node->size; i++) RAII_delete(leaf->entries[i]);
+    }else{
+        BTreeBranch_* branch = (BTreeBranch_*)node;
+        for(unsigned int i = 0; i <= node->size; i++) BTree_release_(branch->children[i]);
+    }
+    Memory_release(node);
+}
+
+// count keys of a node less than key, or not greater than key if inclusive
+static unsigned int BTree_search_(
+    const BTree* tree, void* const* keys, unsigned int size, const void* key, bool inclusive
+){
+    unsigned int low = 0, high = size;
+    while(low < high){
+        const unsigned int middle = (low + high) / 2;
+        const int order = tree->compare_(keys[middle], key);
+        if(order < 0 || (inclusive && order == 0)) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+// get the leaf where key belongs, the root shall not be NULL
+static BTreeLeaf_* BTree_leaf_(const BTree* tree, const void* key){
+    BTreeNode_* node = tree->root_;
+    while(!node->leaf){
+        BTreeBranch_* branch = (BTreeBranch_*)node;
+        node = branch->children[BTree_search_(tree, branch->keys, node->size, key, true)];
+    }
+    return (BTreeLeaf_*)node;
+}
+
+// get the leaf where key belongs along with the path to it, the root shall not be NULL
+static void BTree_descend_(const BTree* tree, const void* key, BTreePath_* path){
+    path->depth = 0;
+    BTreeNode_* node = tree->root_;
+    while(!node->leaf){
+        BTreeBranch_* branch = (BTreeBranch_*)node;
+        const unsigned int index = BTree_search_(tree, branch->keys, node->size, key, true);
+        path->branches[path->depth] = branch;
+        path->indexes[path->depth] = index;
+        path->depth += 1;
+        node = branch->children[index];
+    }
+    path->leaf = (BTreeLeaf_*)node;
+}
+
+// put entry at position of a leaf having room
+static void BTreeLeaf_insert_(BTreeLeaf_* leaf, unsigned int position, KeyValue* entry){
+    const unsigned int moved = leaf->node.size - position;
+    memmove(leaf->keys + position + 1, leaf->keys + position, sizeof(void*) * moved);
+    memmove(leaf->entries + position + 1, leaf->entries + position, sizeof(KeyValue*) * moved);
+    leaf->keys[position] = entry->key;
+    leaf->entries[position] = entry;
+    leaf->node.size += 1;
+}
+
+// take the entry at position out of leaf
+static void BTreeLeaf_remove_(BTreeLeaf_* leaf, unsigned int position){
+    const unsigned int moved = leaf->node.size - position - 1;
+    memmove(leaf->keys + position, leaf->keys + position + 1, sizeof(void*) * moved);
+    memmove(leaf->entries + position, leaf->entries + position + 1, sizeof(KeyValue*) * moved);
+    leaf->node.size -= 1;
+}
+
+// put separator at index of a branch having room, with child right after it
+static void BTreeBranch_insert_(BTreeBranch_* branch, unsigned int index, void* separator, BTreeNode_* child){
+    const unsigned int moved = branch->node.size - index;
+    memmove(branch->keys + index + 1, branch->keys + index, sizeof(void*) * moved);
+    memmove(branch->children + index + 2, branch->children + index + 1, sizeof(BTreeNode_*) * moved);
+    branch->keys[index] = separator;
+    branch->children[index + 1] = child;
+    branch->node.size += 1;
+}
+
+// take the separator at index out of branch, with child right after it
+static void BTreeBranch_remove_(BTreeBranch_* branch, unsigned int index){
+    const unsigned int moved = branch->node.size - index - 1;
+    memmove(branch->keys + index, branch->keys + index + 1, sizeof(void*) * moved);
+    memmove(branch->children + index + 1, branch->children + index + 2, sizeof(BTreeNode_*) * moved);
+    branch->node.size -= 1;
+}
+
+// split a full leaf in halves, putting entry at position, return the half split off to the right
+static BTreeLeaf_* BTree_split_leaf_(BTreeLeaf_* leaf, unsigned int position, KeyValue* entry){
+    const unsigned int half = BTree_Fanout / 2;
+    BTreeLeaf_* right = BTree_leaf_create_();
+    memcpy(right->keys, leaf->keys + half, sizeof(void*) * (BTree_Fanout - half));
+    memcpy(right->entries, leaf->entries + half, sizeof(KeyValue*) * (BTree_Fanout - half));
+    right->node.size = BTree_Fanout - half;
+    leaf->node.size = half;
+    right->next = leaf->next;
+    leaf->next = right;
+    if(position <= half) BTreeLeaf_insert_(leaf, position, entry);
+    else BTreeLeaf_insert_(right, position - half, entry);
+    return right;
+}
+
+// split a full branch in halves, putting separator at index with child right after it
+//  separator receives the separator to put into the parent in place of it
+//  return the half split off to the right
+static BTreeBranch_* BTree_split_branch_(
+    BTreeBranch_* branch, unsigned int index, void** separator, BTreeNode_* child
+){
+    // gather all separators and children in order first, which are one more than fit
+    void* keys[BTree_Fanout];
+    BTreeNode_* children[BTree_Fanout + 1];
+    const unsigned int moved = BTree_Fanout - 1 - index;
+    memcpy(keys, branch->keys, sizeof(void*) * index);
+    keys[index] = *separator;
+    memcpy(keys + index + 1, branch->keys + index, sizeof(void*) * moved);
+    memcpy(children, branch->children, sizeof(BTreeNode_*) * (index + 1));
+    children[index + 1] = child;
+    memcpy(children + index + 2, branch->children + index + 1, sizeof(BTreeNode_*) * moved);
+    // the left half keeps half of children, the separator between halves moves up
+    const unsigned int half = BTree_Fanout / 2;
+    BTreeBranch_* right = BTree_branch_create_();
+    memcpy(branch->keys, keys, sizeof(void*) * (half - 1));
+    memcpy(branch->children, children, sizeof(BTreeNode_*) * half);
+    branch->node.size = half - 1;
+    *separator = keys[half - 1];
+    memcpy(right->keys, keys + half, sizeof(void*) * (BTree_Fanout - half));
+    memcpy(right->children, children + half, sizeof(BTreeNode_*) * (BTree_Fanout + 1 - half));
+    right->node.size = BTree_Fanout - half;
+    return right;
+}
+
+// refill the leaf at index of parent, which has fewer than BTree_MinEntries_ entries
+static void BTree_rebalance_leaf_(BTreeBranch_* parent, unsigned int index){
+    BTreeLeaf_* leaf = (BTreeLeaf_*)parent->children[index];
+    BTreeLeaf_* left = index > 0 ? (BTreeLeaf_*)parent->children[index - 1] : NULL;
+    BTreeLeaf_* right = index < parent->node.size ? (BTreeLeaf_*)parent->children[index + 1] : NULL;
+    if(left != NULL && left->node.size > BTree_MinEntries_){
+        left->node.size -= 1;
+        BTreeLeaf_insert_(leaf, 0, left->entries[left->node.size]);
+        parent->keys[index - 1] = leaf->keys[0];
+    }else if(right != NULL && right->node.size > BTree_MinEntries_){
+        BTreeLeaf_insert_(leaf, leaf->node.size, right->entries[0]);
+        BTreeLeaf_remove_(right, 0);
+        parent->keys[index] = right->keys[0];
+    }else{
+        // merge the right one of two leaves into the left one
+        if(left == NULL){
+            left = leaf;
+            leaf = right;
+            index += 1;
+        }
+        memcpy(left->keys + left->node.size, leaf->keys, sizeof(void*) * leaf->node.size);
+        memcpy(left->entries + left->node.size, leaf->entries, sizeof(KeyValue*) * leaf->node.size);
+        left->node.size += leaf->node.size;
+        left->next = leaf->next;
+        BTreeBranch_remove_(parent, index - 1);
+        Memory_release(leaf);
+    }
+}
+
+// refill the branch at index of parent, which has fewer than BTree_MinChildren_ children
+//  separators are rotated through the parent, so that each stays the least key of the child after it
+static void BTree_rebalance_branch_(BTreeBranch_* parent, unsigned int index){
+    BTreeBranch_* branch = (BTreeBranch_*)parent->children[index];
+    BTreeBranch_* left = index > 0 ? (BTreeBranch_*)parent->children[index - 1] : NULL;
+    BTreeBranch_* right = index < parent->node.size ? (BTreeBranch_*)parent->children[index + 1] : NULL;
+    const unsigned int size = branch->node.size;
+    if(left != NULL && left->node.size >= BTree_MinChildren_){
+        memmove(branch->keys + 1, branch->keys, sizeof(void*) * size);
+        memmove(branch->children + 1, branch->children, sizeof(BTreeNode_*) * (size + 1));
+        branch->keys[0] = parent->keys[index - 1];
+        branch->children[0] = left->children[left->node.size];
+        branch->node.size += 1;
+        parent->keys[index - 1] = left->keys[left->node.size - 1];
+        left->node.size -= 1;
+    }else if(right != NULL && right->node.size >= BTree_MinChildren_){
+        branch->keys[size] = parent->keys[index];
+        branch->children[size + 1] = right->children[0];
+        branch->node.size += 1;
+        parent->keys[index] = right->keys[0];
+        memmove(right->keys, right->keys + 1, sizeof(void*) * (right->node.size - 1));
+        memmove(right->children, right->children + 1, sizeof(BTreeNode_*) * right->node.size);
+        right->node.size -= 1;
+    }else{
+        // merge the right one of two branches into the left one, with the separator between them
+        if(left == NULL){
+            left = branch;
+            branch = right;
+            index += 1;
+        }
+        left->keys[left->node.size] = parent->keys[index - 1];
+        memcpy(left->keys + left->node.size + 1, branch->keys, sizeof(void*) * branch->node.size);
+        memcpy(
+            left->children + left->node.size + 1, branch->children, sizeof(BTreeNode_*) * (branch->node.size + 1)
+        );
+        left->node.size += branch->node.size + 1;
+        BTreeBranch_remove_(parent, index - 1);
+        Memory_release(branch);
+    }
+}
+
+// get an iterator at position of leaf, moving on to the next leaf if position is past its last entry
+static BTreeIterator BTree_iterator_(BTreeLeaf_* leaf, unsigned int position){
+    if(leaf != NULL && position == leaf->node.size){
+        leaf = leaf->next;
+        position = 0;
+    }
+    return (BTreeIterator){.leaf_ = leaf, .index_ = position};
+}
+
+// get the leaf holding the least key, NULL if tree is empty
+static BTreeLeaf_* BTree_first_leaf_(BTree* tree){
+    BTreeNode_* node = tree->root_;
+    if(node == NULL) return NULL;
+    while(!node->leaf) node = ((BTreeBranch_*)node)->children[0];
+    return (BTreeLeaf_*)node;
+}
+
+static void BTree_deleter_(void* target_){
+    BTree_clear((BTree*)target_);
+}
+
+BTree* BTree_create(int (*compare)(const void* lhs_, const void* rhs_)){
+    Profile_allocating_(ProfileKind_BTree);
+    BTree* tree = (BTree*)Memory_allocate_object(sizeof(BTree));
+    tree->root_ = NULL;
+    tree->size_ = 0;
+    tree->compare_ = compare;
+    RAII_set_deleter(tree, BTree_deleter_);
+    return tree;
+}
+
+void BTree_clear(BTree* tree){
+    if(tree->root_ != NULL) BTree_release_(tree->root_);
+    tree->root_ = NULL;
+    tree->size_ = 0;
+}
+
+size_t BTree_size(BTree* tree){
+    return tree->size_;
+}
+
+bool BTree_insert(BTree* tree, void* key, bool owns_key, void* value, bool owns_value, KeyValue** result){
+    Profile_operation_(ProfileKind_BTree);
+    if(tree->root_ == NULL) tree->root_ = &BTree_leaf_create_()->node;
+    BTreePath_ path;
+    BTree_descend_(tree, key, &path);
+    BTreeLeaf_* leaf = path.leaf;
+    const unsigned int position = BTree_search_(tree, leaf->keys, leaf->node.size, key, false);
+    if(position < leaf->node.size && tree->compare_(leaf->keys[position], key) == 0){
+        if(result != NULL) *result = leaf->entries[position];
+        return false;
+    }
+    Profile_allocating_(ProfileKind_BTree);
+    KeyValue* entry = KeyValue_create(key, owns_key, value, owns_value);
+    if(result != NULL) *result = entry;
+    tree->size_ += 1;
+    if(leaf->node.size < BTree_Fanout){
+        BTreeLeaf_insert_(leaf, position, entry);
+        return true;
+    }
+    // split nodes up the path as long as they are full
+    BTreeLeaf_* split = BTree_split_leaf_(leaf, position, entry);
+    void* separator = split->keys[0];
+    BTreeNode_* child = &split->node;
+    while(path.depth > 0){
+        path.depth -= 1;
+        BTreeBranch_* parent = path.branches[path.depth];
+        if(parent->node.size < BTree_Fanout - 1){
+            BTreeBranch_insert_(parent, path.indexes[path.depth], separator, child);
+            return true;
+        }
+        child = &BTree_split_branch_(parent, path.indexes[path.depth], &separator, child)->node;
+    }
+    BTreeBranch_* root = BTree_branch_create_();
+    root->keys[0] = separator;
+    root->children[0] = tree->root_;
+    root->children[1] = child;
+    root->node.size = 1;
+    tree->root_ = &root->node;
+    return true;
+}
+
+void BTree_build(BTree* tree, void** keys, bool owns_keys, void** values, bool owns_values, size_t count){
+    assert(tree->root_ == NULL);
+    if(count == 0) return;
+    // spread entries over as few leaves as possible, as evenly as possible, so that no leaf but the root
+    //  has fewer than half of the most entries
+    size_t nodes = (count + BTree_Fanout - 1) / BTree_Fanout;
+    BTreeNode_** level = (BTreeNode_**)Memory_allocate(sizeof(BTreeNode_*) * nodes);
+    void** least = (void**)Memory_allocate(sizeof(void*) * nodes);
+    BTreeLeaf_* previous = NULL;
+    for(size_t i = 0, next = 0; i < nodes; i++){
+        BTreeLeaf_* leaf = BTree_leaf_create_();
+        leaf->node.size = count / nodes + (i < count % nodes);
+        for(unsigned int j = 0; j < leaf->node.size; j++, next++){
+            Profile_allocating_(ProfileKind_BTree);
+            leaf->entries[j] = KeyValue_create(
+                keys[next], owns_keys, values == NULL ? NULL : values[next], owns_values
+            );
+            leaf->keys[j] = keys[next];
+        }
+        if(previous != NULL) previous->next = leaf;
+        previous = leaf;
+        level[i] = &leaf->node;
+        least[i] = leaf->keys[0];
+    }
+    // build each level of branches over the one below in the same way, until a single node is left
+    //  nodes of the new level are stored in place of the level below, which has been passed over by then
+    while(nodes > 1){
+        const size_t parents = (nodes + BTree_Fanout - 1) / BTree_Fanout;
+        for(size_t i = 0, next = 0; i < parents; i++){
+            BTreeBranch_* branch = BTree_branch_create_();
+            const size_t children = nodes / parents + (i < nodes % parents);
+            for(size_t j = 0; j < children; j++, next++){
+                branch->children[j] = level[next];
+                if(j != 0) branch->keys[j - 1] = least[next];
+            }
+            branch->node.size = children - 1;
+            least[i] = least[next - children];
+            level[i] = &branch->node;
+        }
+        nodes = parents;
+    }
+    tree->root_ = level[0];
+    tree->size_ = count;
+    Memory_release(least);
+    Memory_release(level);
+}
+
+KeyValue* BTree_find(BTree* tree, const void* key){
+    Profile_operation_(ProfileKind_BTree);
+    if(tree->root_ == NULL) return NULL;
+    BTreeLeaf_* leaf = BTree_leaf_(tree, key);
+    const unsigned int position = BTree_search_(tree, leaf->keys, leaf->node.size, key, false);
+    if(position == leaf->node.size || tree->compare_(leaf->keys[position], key) != 0) return NULL;
+    return leaf->entries[position];
+}
+
+bool BTree_erase(BTree* tree, const void* key){
+    Profile_operation_(ProfileKind_BTree);
+    if(tree->root_ == NULL) return false;
+    BTreePath_ path;
+    BTree_descend_(tree, key, &path);
+    BTreeLeaf_* leaf = path.leaf;
+    const unsigned int position = BTree_search_(tree, leaf->keys, leaf->node.size, key, false);
+    if(position == leaf->node.size || tree->compare_(leaf->keys[position], key) != 0) return false;
+    KeyValue* entry = leaf->entries[position];
+    BTreeLeaf_remove_(leaf, position);
+    tree->size_ -= 1;
+    // whether the least key of the subtree reached so far has changed, which is then the least key of leaf
+    bool least = position == 0 && leaf->node.size != 0;
+    BTreeNode_* node = &leaf->node;
+    while(path.depth > 0){
+        path.depth -= 1;
+        BTreeBranch_* parent = path.branches[path.depth];
+        const unsigned int index = path.indexes[path.depth];
+        if(least && index > 0){
+            parent->keys[index - 1] = leaf->keys[0];
+            least = false;
+        }
+        if(node->leaf && node->size < BTree_MinEntries_) BTree_rebalance_leaf_(parent, index);
+        else if(!node->leaf && node->size + 1 < BTree_MinChildren_) BTree_rebalance_branch_(parent, index);
+        else if(!least) break;
+        node = &parent->node;
+    }
+    if(tree->root_->leaf){
+        if(tree->root_->size == 0){
+            Memory_release(tree->root_);
+            tree->root_ = NULL;
+        }
+    }else if(tree->root_->size == 0){
+        // the root left with a single child is replaced by the child
+        BTreeBranch_* root = (BTreeBranch_*)tree->root_;
+        tree->root_ = root->children[0];
+        Memory_release(root);
+    }
+    RAII_delete(entry);
+    return true;
+}
+
+BTreeIterator BTree_begin(BTree* tree){
+    return BTree_iterator_(BTree_first_leaf_(tree), 0);
+}
+
+BTreeIterator BTree_lower_bound(BTree* tree, const void* key){
+    Profile_operation_(ProfileKind_BTree);
+    if(tree->root_ == NULL) return BTree_iterator_(NULL, 0);
+    BTreeLeaf_* leaf = BTree_leaf_(tree, key);
+    return BTree_iterator_(leaf, BTree_search_(tree, leaf->keys, leaf->node.size, key, false));
+}
+
+BTreeIterator BTree_upper_bound(BTree* tree, const void* key){
+    Profile_operation_(ProfileKind_BTree);
+    if(tree->root_ == NULL) return BTree_iterator_(NULL, 0);
+    BTreeLeaf_* leaf = BTree_leaf_(tree, key);
+    return BTree_iterator_(leaf, BTree_search_(tree, leaf->keys, leaf->node.size, key, true));
+}
+
+KeyValue* BTreeIterator_entry(const BTreeIterator* iterator){
+    if(iterator->leaf_ == NULL) return NULL;
+    return ((BTreeLeaf_*)iterator->leaf_)->entries[iterator->index_];
+}
+
+void BTreeIterator_next(BTreeIterator* iterator){
+    if(iterator->leaf_ == NULL) return;
+    *iterator = BTree_iterator_((BTreeLeaf_*)iterator->leaf_, iterator->index_ + 1);
+}
+
+void BTree_foreach(BTree* tree, void (*visit)(KeyValue* entry, void* context), void* context){
+    for(BTreeLeaf_* leaf = BTree_first_leaf_(tree); leaf != NULL; leaf = leaf->next){
+        for(unsigned int i = 0; i < leaf->node.size; i++) visit(leaf->entries[i], context);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef CxKANOAXDP_btree_H_
+#define CxKANOAXDP_btree_H_
+#include "keyvalue_pair.h"
+#include <stdbool.h>
+#include <stddef.h>
+// ordered map keeping entries sorted by key in a B+tree, with no two entries of the same key
+//  entries are stored in leaves linked in order of keys, branches above hold only keys separating their
+//   children. Each node keeps its keys in an array of its own, aligned to cache lines, so that a lookup
+//   reads a few cache lines per level and compares keys within a node by binary search
+//  entries are allocated one by one and stay where they are while the tree changes, so that an entry serves
+//   as a handle to its key and value until it is removed. The key of an entry must not be changed
+//  a tree is a RAII object
+typedef struct BTree BTree;
+enum BTree_Constant{
+    BTree_Fanout = 16,  // most children of a branch and most entries of a leaf, half as many at least
+};
+// position in a tree, going through entries in order of keys
+//  entries with keys from a to b exclusively run from BTree_lower_bound of a up to the entry at
+//   BTree_lower_bound of b, which takes time logarithmic to size of tree plus number of entries visited
+//  an iterator is invalidated once an entry is inserted to or removed from its tree
+typedef struct{
+    void* leaf_;
+    unsigned int index_;
+}BTreeIterator;
+
+// create a new tree
+//  compare specifies the order by which the entries are arranged
+BTree* BTree_create(int (*compare)(const void* lhs_, const void* rhs_));
+
+// remove all entries from tree
+void BTree_clear(BTree* tree);
+
+// get number of entries in tree
+size_t BTree_size(BTree* tree);
+
+// insert a new entry to tree if no entry with the same key exists
+//  the owns_{key, value} parameter specify if the {key, value} shall be managed in the same way as
+//   Heap_insert. They are left to the caller if the entry is not inserted
+//  result receives the entry with key, either inserted or existing, if not NULL
+//  return if the entry is inserted
+bool BTree_insert(BTree* tree, void* key, bool owns_key, void* value, bool owns_value, KeyValue** result);
+
+// insert multiple entries to an empty tree at once, which takes linear time
+//  keys and values are arrays of count elements, keys shall be in ascending order without duplicates, values
+//   may be NULL in which case all values are NULL
+//  ownership is specified for all keys or all values together in the same way as BTree_insert
+void BTree_build(BTree* tree, void** keys, bool owns_keys, void** values, bool owns_values, size_t count);
+
+// lookup entry with key within tree, return NULL if not found
+KeyValue* BTree_find(BTree* tree, const void* key);
+
+// remove the entry with key from tree, return if an entry is removed
+bool BTree_erase(BTree* tree, const void* key);
+
+// get an iterator at the entry with the least key in tree
+BTreeIterator BTree_begin(BTree* tree);
+
+// get an iterator at the first entry whose key is not less than key
+BTreeIterator BTree_lower_bound(BTree* tree, const void* key);
+
+// get an iterator at the first entry whose key is greater than key
+BTreeIterator BTree_upper_bound(BTree* tree, const void* key);
+
+// get the entry iterator is at, or NULL if it has gone past the last entry
+KeyValue* BTreeIterator_entry(const BTreeIterator* iterator);
+
+// move iterator to the entry with the next greater key
+//  an iterator past the last entry stays there
+void BTreeIterator_next(BTreeIterator* iterator);
+
+// call visit on every entry in tree along with context
+//  entries are visited in order of keys. The tree must not be modified meanwhile
+void BTree_foreach(BTree* tree, void (*visit)(KeyValue* entry, void* context), void* context);
+#endif
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "cache.h"
+#include "RAII.h"
+#include "hashtable.h"
+#include "memory.h"
+#include "profile.h"
+#include "list.h"
+// node in eviction order, which is the value of its entry in table
+//  the link must be the first member since the node is deleted through it, and its data is the value
+typedef struct{
+    ListNode link;
+    KeyValue* entry;
+    size_t cost;
+    // set when got, cleared when passed over by CLOCK
+    bool referenced;
+}CacheNode_;
+struct Cache{
+    RAII _;
+    HashTable table_;
+    // entries to be evicted first are at front
+    List order_;
+    enum CachePolicy policy_;
+    size_t budget_;
+    size_t cost_;
+};
+
+// deleter of node whose value is managed
+static void CacheNode_deleter_(void* target_){
+    RAII_delete(((CacheNode_*)target_)->link.data);
+}
+
+// set value of node, along with deleter according to its ownership
+static void CacheNode_set_value_(CacheNode_* node, void* value, bool owns_value){
+    node->link.data = value;
+    if(owns_value) RAII_set_deleter(node, CacheNode_deleter_);
+    else RAII_set_dummy_deleter(node);
+}
+
+// remove an entry from both order and table, deallocating key and value if managed
+static void Cache_remove_(Cache* cache, CacheNode_* node){
+    cache->cost_ -= node->cost;
+    List_detach(&cache->order_, &node->link);
+    HashTable_erase_entry(&cache->table_, node->entry);
+}
+
+// mark an entry as used according to policy
+static inline void Cache_touch_(Cache* cache, CacheNode_* node){
+    if(cache->policy_ == CachePolicy_LRU){
+        List_detach(&cache->order_, &node->link);
+        List_emplace_back(&cache->order_, &node->link);
+    }else{
+        node->referenced = true;
+    }
+}
+
+// destroy the cache
+static void Cache_destroy_(Cache* cache){
+    // nodes are owned by table, order only links them
+    List_initialize(&cache->order_);
+    RAII_destroy(&cache->table_);
+}
+
+Cache* Cache_create(
+    enum CachePolicy policy,
+    size_t budget,
+    unsigned int (*hash)(const void* target_),
+    int (*compare)(const void* lhs_, const void* rhs_)
+){
+    Profile_allocating_(ProfileKind_Cache);
+    Cache* cache = (Cache*)Memory_allocate_object(sizeof(Cache));
+    HashTable_initialize(&cache->table_, 1, hash, compare);
+    List_initialize(&cache->order_);
+    cache->policy_ = policy;
+    cache->budget_ = budget;
+    cache->cost_ = 0;
+    RAII_set_deleter(cache, (void(*)(void*))Cache_destroy_);
+    return cache;
+}
+
+void Cache_clear(Cache* cache){
+    List_initialize(&cache->order_);
+    HashTable_clear(&cache->table_);
+    cache->cost_ = 0;
+}
+
+void Cache_clear_deferred(Cache* cache){
+    List_initialize(&cache->order_);
+    HashTable_clear_deferred(&cache->table_);
+    cache->cost_ = 0;
+}
+
+size_t Cache_size(Cache* cache){
+    return cache->table_.size;
+}
+
+size_t Cache_cost(Cache* cache){
+    return cache->cost_;
+}
+
+void* Cache_get(Cache* cache, void* key){
+    Profile_operation_(ProfileKind_Cache);
+    KeyValue* entry = HashTable_find(&cache->table_, key);
+    if(entry == NULL) return NULL;
+    CacheNode_* node = (CacheNode_*)entry->value;
+    Cache_touch_(cache, node);
+    return node->link.data;
+}
+
+bool Cache_put(Cache* cache, void* key, bool owns_key, void* value, bool owns_value, size_t cost){
+    Profile_operation_(ProfileKind_Cache);
+    KeyValue* entry = HashTable_find(&cache->table_, key);
+    if(cost > cache->budget_){
+        // the key or value passed may be the very one stored, which is deleted along with the entry if managed
+        bool deleted_key = false, deleted_value = false;
+        if(entry != NULL){
+            CacheNode_* node = (CacheNode_*)entry->value;
+            deleted_key = entry->key == key && entry->key_owned;
+            deleted_value = node->link.data == value && ((RAII*)node)->deleter == CacheNode_deleter_;
+            Cache_remove_(cache, node);
+        }
+        if(owns_key && !deleted_key) RAII_delete(key);
+        if(owns_value && !deleted_value) RAII_delete(value);
+        return false;
+    }
+    CacheNode_* node;
+    if(entry != NULL){
+        node = (CacheNode_*)entry->value;
+        if(owns_key && entry->key != key) RAII_delete(key);
+        if(node->link.data != value) RAII_destroy(node);
+        CacheNode_set_value_(node, value, owns_value);
+        cache->cost_ -= node->cost;
+        node->cost = 0;
+        // the entry is taken out of order so as not to be evicted while making room for its new cost, and
+        //  goes back as the most recently used
+        List_detach(&cache->order_, &node->link);
+        node->referenced = false;
+    }else{
+        Profile_allocating_(ProfileKind_Cache);
+        node = (CacheNode_*)Memory_allocate_object(sizeof(CacheNode_));
+        CacheNode_set_value_(node, value, owns_value);
+        node->entry = HashTable_insert_direct(&cache->table_, key, owns_key, node, true);
+        node->referenced = false;
+    }
+    while(cache->cost_ + cost > cache->budget_) Cache_evict(cache);
+    node->cost = cost;
+    cache->cost_ += cost;
+    List_emplace_back(&cache->order_, &node->link);
+    return true;
+}
+
+bool Cache_erase(Cache* cache, void* key){
+    Profile_operation_(ProfileKind_Cache);
+    KeyValue* entry = HashTable_find(&cache->table_, key);
+    if(entry == NULL) return false;
+    Cache_remove_(cache, (CacheNode_*)entry->value);
+    return true;
+}
+
+bool Cache_evict(Cache* cache){
+    Profile_operation_(ProfileKind_Cache);
+    if(List_empty(&cache->order_)) return false;
+    CacheNode_* node = (CacheNode_*)cache->order_.head.next;
+    // CLOCK gives entries got since last passed over a second chance, which ends as all flags are cleared
+    while(node->referenced){
+        node->referenced = false;
+        List_detach(&cache->order_, &node->link);
+        List_emplace_back(&cache->order_, &node->link);
+        node = (CacheNode_*)cache->order_.head.next;
+    }
+    Cache_remove_(cache, node);
+    return true;
+}
\ No newline at end of file
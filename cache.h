@@ -0,0 +1,61 @@
+#ifndef CxKANOAXDP_cache_H_
+#define CxKANOAXDP_cache_H_
+#include <stdbool.h>
+#include <stddef.h>
+// policies by which a cache chooses entries to evict
+enum CachePolicy{
+    // evict the entry least recently put or got
+    CachePolicy_LRU,
+    // evict the entry least recently put among those not got since last passed over, which is cheaper than
+    //  LRU on hits since they only mark the entry instead of moving it
+    CachePolicy_Clock,
+};
+
+// cache of key-value pairs limited by a budget on the total cost of entries
+//  entries are kept in a hash table whose values are nodes of the eviction order, therefore getting,
+//   putting and evicting entries all take constant time
+//  evicted keys and values are deallocated through their deleters if managed, which serves as the eviction
+//   callback
+typedef struct Cache Cache;
+
+// create a new cache
+//  budget limits total cost of entries in cache, where the cost of each entry is specified when putting it,
+//   such as number of bytes it takes
+//  hash and compare are used on keys in the same way as HashTable
+Cache* Cache_create(
+    enum CachePolicy policy,
+    size_t budget,
+    unsigned int (*hash)(const void* target_),
+    int (*compare)(const void* lhs_, const void* rhs_)
+);
+
+// remove all entries from cache
+void Cache_clear(Cache* cache);
+
+// remove all entries from cache in constant time, handing them over to the reclaimer thread to be deleted
+void Cache_clear_deferred(Cache* cache);
+
+// get number of entries in cache
+size_t Cache_size(Cache* cache);
+
+// get total cost of entries in cache
+size_t Cache_cost(Cache* cache);
+
+// get value with specified key, marking the entry as used
+//  return NULL if not found
+void* Cache_get(Cache* cache, void* key);
+
+// put an entry into cache, evicting other entries until it fits within budget
+//  ownership of key and value is specified in the same way as HashTable_insert
+//  if an entry with same key exists, its value and cost are replaced and the entry is marked as used. The
+//   key given is deallocated then if managed, as it is not stored
+//  return if the entry is put, which fails only if its cost alone exceeds budget, in which case managed key
+//   and value are deallocated
+bool Cache_put(Cache* cache, void* key, bool owns_key, void* value, bool owns_value, size_t cost);
+
+// remove the entry with specified key, return if an entry is removed
+bool Cache_erase(Cache* cache, void* key);
+
+// evict one entry chosen by policy of cache, return if an entry is evicted
+bool Cache_evict(Cache* cache);
+#endif
\ No newline at end of file
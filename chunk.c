@@ -0,0 +1,64 @@
+#include "chunk.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <threads.h>
+_Atomic(ChunkMapMiddle_*) ChunkMap_root_[ChunkMap_LevelSize];
+// registration is rare, a single lock serializes allocating levels
+static mtx_t ChunkMap_lock_;
+static once_flag ChunkMap_once_ = ONCE_FLAG_INIT;
+
+static void ChunkMap_initialize_(void){
+    mtx_init(&ChunkMap_lock_, mtx_plain);
+}
+
+// get the slot holding owner of chunk containing address
+//  missing levels are allocated if create is set, otherwise NULL is returned
+static _Atomic(ChunkOwner*)* ChunkMap_slot_(const void* address, bool create){
+    const uint64_t number = (uint64_t)(uintptr_t)address >> ChunkMap_ChunkBits;
+    const size_t root_index = (number >> (ChunkMap_LevelBits * 2)) & (ChunkMap_LevelSize - 1);
+    const size_t middle_index = (number >> ChunkMap_LevelBits) & (ChunkMap_LevelSize - 1);
+    const size_t leaf_index = number & (ChunkMap_LevelSize - 1);
+    ChunkMapMiddle_* middle = atomic_load_explicit(ChunkMap_root_ + root_index, memory_order_acquire);
+    if(middle == NULL){
+        if(!create) return NULL;
+        middle = (ChunkMapMiddle_*)calloc(1, sizeof(ChunkMapMiddle_));
+        atomic_store_explicit(ChunkMap_root_ + root_index, middle, memory_order_release);
+    }
+    ChunkMapLeaf_* leaf = atomic_load_explicit(middle->leaves + middle_index, memory_order_acquire);
+    if(leaf == NULL){
+        if(!create) return NULL;
+        leaf = (ChunkMapLeaf_*)calloc(1, sizeof(ChunkMapLeaf_));
+        atomic_store_explicit(middle->leaves + middle_index, leaf, memory_order_release);
+    }
+    return leaf->owners + leaf_index;
+}
+
+// round size up to whole chunks
+static inline size_t Chunk_round_(size_t size){
+    return size == 0 ? Chunk_Size : (size + Chunk_Size - 1) & ~(size_t)(Chunk_Size - 1);
+}
+
+void* Chunk_allocate(ChunkOwner* owner, size_t size){
+    size = Chunk_round_(size);
+    const Allocator* allocator = owner->allocator != NULL ? owner->allocator : Memory_allocator();
+    char* chunk = (char*)allocator->allocate(allocator->context, size, Chunk_Size);
+    if(chunk == NULL) return NULL;
+    call_once(&ChunkMap_once_, ChunkMap_initialize_);
+    mtx_lock(&ChunkMap_lock_);
+    for(size_t offset = 0; offset < size; offset += Chunk_Size){
+        atomic_store_explicit(ChunkMap_slot_(chunk + offset, true), owner, memory_order_release);
+    }
+    mtx_unlock(&ChunkMap_lock_);
+    return chunk;
+}
+
+void Chunk_release(void* chunk, size_t size){
+    size = Chunk_round_(size);
+    const ChunkOwner* owner = Chunk_owner(chunk);
+    const Allocator* allocator = owner->allocator != NULL ? owner->allocator : Memory_allocator();
+    // slots exist as long as chunks are registered, and levels are never freed
+    for(size_t offset = 0; offset < size; offset += Chunk_Size){
+        atomic_store_explicit(ChunkMap_slot_((char*)chunk + offset, false), NULL, memory_order_relaxed);
+    }
+    allocator->release(allocator->context, chunk);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef CxKANOAXDP_chunk_H_
+#define CxKANOAXDP_chunk_H_
+#include "memory.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+// registry of large aligned blocks of memory, named chunks, each owned by an allocator carving objects out of it
+//  any address within a chunk leads to its owner in constant time without locking, so that objects can be
+//   released to the allocator they come from knowing nothing but their address
+enum Chunk_Constant{
+    Chunk_Size = 1 << 16,   // size of each chunk in bytes, which chunks are also aligned to
+};
+
+// allocator owning chunks, which objects within its chunks are released to
+typedef struct ChunkOwner ChunkOwner;
+struct ChunkOwner{
+    void (*release)(ChunkOwner* owner, void* object);
+    // resize a block given out by Memory_allocate, NULL if the owner never gives out such blocks
+    void* (*reallocate)(ChunkOwner* owner, void* block, size_t size);
+    // source of chunks of the owner, NULL for the allocator of the library
+    const Allocator* allocator;
+};
+
+// allocate a block of at least size bytes, made of whole chunks, and register all of them as owned by owner
+//  return NULL if out of memory
+void* Chunk_allocate(ChunkOwner* owner, size_t size);
+
+// unregister a block of chunks allocated with specified size, and return it to the allocator of its owner
+void Chunk_release(void* chunk, size_t size);
+
+// get the start of the chunk containing address
+static inline void* Chunk_of(const void* address){
+    return (void*)((uintptr_t)address & ~(uintptr_t)(Chunk_Size - 1));
+}
+
+enum ChunkMap_Constant{
+    ChunkMap_LevelBits = 16,                    // bits of chunk number resolved by each level of map
+    ChunkMap_LevelSize = 1 << ChunkMap_LevelBits,
+    ChunkMap_ChunkBits = 16,                    // bits of address within a chunk, Chunk_Size is 2 to this
+};
+// the map from chunk number, which is address without bits within chunk, to owner of chunk is a radix tree
+//  of three levels, which covers 48 bits of chunk numbers and hence all 64 bits of addresses
+//  levels are allocated on first chunk registered under them and never freed, so readers need no lock
+typedef struct{
+    _Atomic(ChunkOwner*) owners[ChunkMap_LevelSize];
+}ChunkMapLeaf_;
+typedef struct{
+    _Atomic(ChunkMapLeaf_*) leaves[ChunkMap_LevelSize];
+}ChunkMapMiddle_;
+extern _Atomic(ChunkMapMiddle_*) ChunkMap_root_[ChunkMap_LevelSize];
+
+// get the owner of the chunk containing address, return NULL if address is in no chunk
+//  this is on the path of releasing every object, hence inline
+static inline ChunkOwner* Chunk_owner(const void* address){
+    const uint64_t number = (uint64_t)(uintptr_t)address >> ChunkMap_ChunkBits;
+    ChunkMapMiddle_* middle = atomic_load_explicit(
+        ChunkMap_root_ + ((number >> (ChunkMap_LevelBits * 2)) & (ChunkMap_LevelSize - 1)), memory_order_acquire
+    );
+    if(middle == NULL) return NULL;
+    ChunkMapLeaf_* leaf = atomic_load_explicit(
+        middle->leaves + ((number >> ChunkMap_LevelBits) & (ChunkMap_LevelSize - 1)), memory_order_acquire
+    );
+    if(leaf == NULL) return NULL;
+    return atomic_load_explicit(leaf->owners + (number & (ChunkMap_LevelSize - 1)), memory_order_acquire);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,348 @@
+#include "concurrent_hashtable.h"
+#include "RAII.h"
+#include "memory.h"
+#include "profile.h"
+#include <limits.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <threads.h>
+enum ConcurrentHashTable_Constant{
+    ConcurrentHashTable_CacheLine = 64,     // size of cache line, used to keep counters and locks apart
+    ConcurrentHashTable_Stripes = 64,       // number of locks for writers, must be a power of 2
+    ConcurrentHashTable_ReaderSlots = 64,   // number of counters readers are spread over
+    ConcurrentHashTable_MaxLoadFactor = 1,  // grow once there are more entries than this many per line
+    ConcurrentHashTable_RetireBatch = 64,   // objects retired before waiting for readers to reclaim them
+};
+// entry in a chain, which is never modified once published except for its link being replaced
+typedef struct ConcurrentHashTableNode_{
+    _Atomic(struct ConcurrentHashTableNode_*) next;
+    KeyValue* entry;
+    unsigned int hash;
+}ConcurrentHashTableNode_;
+// index of lines, replaced as a whole when the table grows
+typedef struct{
+    size_t lines;
+    _Atomic(ConcurrentHashTableNode_*) heads[];
+}ConcurrentHashTableIndex_;
+// lock of writers along with the number of entries in the lines it covers
+typedef struct{
+    alignas(ConcurrentHashTable_CacheLine) mtx_t lock;
+    size_t size;
+}ConcurrentHashTableStripe_;
+// number of readers in critical sections, counted separately for the two most recent epochs
+typedef struct{
+    alignas(ConcurrentHashTable_CacheLine) atomic_size_t readers[2];
+}ConcurrentHashTableReaders_;
+// object unlinked from table, waiting for readers to leave before being released
+typedef struct ConcurrentHashTableRetired_{
+    struct ConcurrentHashTableRetired_* next;
+    void* target;
+    void (*release)(void* target);
+}ConcurrentHashTableRetired_;
+struct ConcurrentHashTable{
+    RAII _;
+    _Atomic(ConcurrentHashTableIndex_*) index_;
+    unsigned int (*hash_)(const void* key);
+    int (*compare_)(const void* lhs_, const void* rhs_);
+    ConcurrentHashTableStripe_ stripes_[ConcurrentHashTable_Stripes];
+    ConcurrentHashTableReaders_ readers_[ConcurrentHashTable_ReaderSlots];
+    // epoch is advanced by each reclamation, readers register themselves under its parity
+    atomic_uint epoch_;
+    // reclamation is serialized by its own lock, retired objects are collected under another
+    mtx_t reclaim_lock_;
+    mtx_t retire_lock_;
+    ConcurrentHashTableRetired_* retired_;
+    size_t retired_count_;
+};
+
+// number of read-side critical sections the calling thread is in, across all tables
+//  reclamation waits for readers, so a thread must not start it while being one itself
+static _Thread_local unsigned int ConcurrentHashTable_read_depth_ = 0;
+
+// get the reader counter slot of calling thread, threads are assigned to slots in turn
+static unsigned int ConcurrentHashTable_reader_slot_(void){
+    static atomic_uint next_slot = 0;
+    static _Thread_local unsigned int slot = UINT_MAX;
+    if(slot == UINT_MAX){
+        slot = atomic_fetch_add_explicit(&next_slot, 1, memory_order_relaxed) % ConcurrentHashTable_ReaderSlots;
+    }
+    return slot;
+}
+
+// allocate an index of empty lines
+static ConcurrentHashTableIndex_* ConcurrentHashTable_allocate_index_(size_t lines){
+    Profile_allocating_(ProfileKind_ConcurrentHashTable);
+    ConcurrentHashTableIndex_* index = (ConcurrentHashTableIndex_*)Memory_allocate(
+        sizeof(ConcurrentHashTableIndex_) + sizeof(_Atomic(ConcurrentHashTableNode_*)) * lines
+    );
+    index->lines = lines;
+    for(size_t i = 0; i < lines; i++) atomic_init(index->heads + i, NULL);
+    return index;
+}
+
+// release an index along with nodes in it, but not the entries they refer to
+static void ConcurrentHashTable_release_index_(void* target){
+    ConcurrentHashTableIndex_* index = (ConcurrentHashTableIndex_*)target;
+    for(size_t i = 0; i < index->lines; i++){
+        ConcurrentHashTableNode_* node = atomic_load_explicit(index->heads + i, memory_order_relaxed);
+        while(node != NULL){
+            ConcurrentHashTableNode_* next = atomic_load_explicit(&node->next, memory_order_relaxed);
+            Memory_release(node);
+            node = next;
+        }
+    }
+    Memory_release(index);
+}
+
+// release a node along with the entry it refers to
+static void ConcurrentHashTable_release_node_(void* target){
+    ConcurrentHashTableNode_* node = (ConcurrentHashTableNode_*)target;
+    RAII_delete(node->entry);
+    Memory_release(node);
+}
+
+// wait until all readers that might have seen objects retired so far have left their critical sections
+//  reclaim lock must be held, since parities of two reclamations overlapping would get mixed up
+static void ConcurrentHashTable_synchronize_(ConcurrentHashTable* table){
+    const unsigned int epoch = atomic_fetch_add_explicit(&table->epoch_, 1, memory_order_seq_cst);
+    // readers entering from now on register under the other parity, wait for those under the old one
+    for(unsigned int i = 0; i < ConcurrentHashTable_ReaderSlots; i++){
+        while(atomic_load_explicit(table->readers_[i].readers + (epoch & 1), memory_order_seq_cst) != 0){
+            thrd_yield();
+        }
+    }
+}
+
+// release all objects retired so far
+//  the retired list is taken out before waiting, so that readers retiring objects meanwhile are not blocked
+static void ConcurrentHashTable_reclaim_(ConcurrentHashTable* table){
+    mtx_lock(&table->retire_lock_);
+    ConcurrentHashTableRetired_* retired = table->retired_;
+    table->retired_ = NULL;
+    table->retired_count_ = 0;
+    mtx_unlock(&table->retire_lock_);
+    if(retired == NULL) return;
+    mtx_lock(&table->reclaim_lock_);
+    ConcurrentHashTable_synchronize_(table);
+    mtx_unlock(&table->reclaim_lock_);
+    while(retired != NULL){
+        ConcurrentHashTableRetired_* next = retired->next;
+        retired->release(retired->target);
+        Memory_release(retired);
+        retired = next;
+    }
+}
+
+// retire an object unlinked from table, to be released once no reader may access it
+static void ConcurrentHashTable_retire_(ConcurrentHashTable* table, void* target, void (*release)(void* target)){
+    Profile_allocating_(ProfileKind_ConcurrentHashTable);
+    ConcurrentHashTableRetired_* retired = (ConcurrentHashTableRetired_*)Memory_allocate_object(
+        sizeof(ConcurrentHashTableRetired_)
+    );
+    retired->target = target;
+    retired->release = release;
+    mtx_lock(&table->retire_lock_);
+    retired->next = table->retired_;
+    table->retired_ = retired;
+    table->retired_count_ += 1;
+    const bool full = table->retired_count_ >= ConcurrentHashTable_RetireBatch;
+    mtx_unlock(&table->retire_lock_);
+    if(full && ConcurrentHashTable_read_depth_ == 0) ConcurrentHashTable_reclaim_(table);
+}
+
+// get the stripe covering lines of specified hash
+static inline ConcurrentHashTableStripe_* ConcurrentHashTable_stripe_(ConcurrentHashTable* table, unsigned int hash){
+    return table->stripes_ + (hash & (ConcurrentHashTable_Stripes - 1));
+}
+
+// double the number of lines unless someone else did since index was observed
+//  nodes are copied rather than moved, so that readers on the old index are not disturbed
+//  all writers are stalled meanwhile, for time linear to size of table
+static void ConcurrentHashTable_grow_(ConcurrentHashTable* table, ConcurrentHashTableIndex_* index){
+    for(unsigned int i = 0; i < ConcurrentHashTable_Stripes; i++) mtx_lock(&table->stripes_[i].lock);
+    if(atomic_load_explicit(&table->index_, memory_order_relaxed) == index){
+        ConcurrentHashTableIndex_* grown = ConcurrentHashTable_allocate_index_(index->lines << 1);
+        for(size_t i = 0; i < index->lines; i++){
+            ConcurrentHashTableNode_* node = atomic_load_explicit(index->heads + i, memory_order_relaxed);
+            for(; node != NULL; node = atomic_load_explicit(&node->next, memory_order_relaxed)){
+                Profile_allocating_(ProfileKind_ConcurrentHashTable);
+                ConcurrentHashTableNode_* copy = (ConcurrentHashTableNode_*)Memory_allocate_object(
+                    sizeof(ConcurrentHashTableNode_)
+                );
+                _Atomic(ConcurrentHashTableNode_*)* head = grown->heads + (node->hash & (grown->lines - 1));
+                copy->entry = node->entry;
+                copy->hash = node->hash;
+                atomic_init(&copy->next, atomic_load_explicit(head, memory_order_relaxed));
+                atomic_init(head, copy);
+            }
+        }
+        atomic_store_explicit(&table->index_, grown, memory_order_release);
+    }else{
+        index = NULL;
+    }
+    for(unsigned int i = ConcurrentHashTable_Stripes; i > 0; i--) mtx_unlock(&table->stripes_[i - 1].lock);
+    if(index == NULL) return;
+    // an index holds as many nodes as entries in table, and growing alone retires too few objects to ever
+    //  fill a batch, so it is reclaimed right away unless the calling thread is a reader itself
+    ConcurrentHashTable_retire_(table, index, ConcurrentHashTable_release_index_);
+    if(ConcurrentHashTable_read_depth_ == 0) ConcurrentHashTable_reclaim_(table);
+}
+
+// destroy the table
+static void ConcurrentHashTable_destroy_(ConcurrentHashTable* table){
+    ConcurrentHashTable_clear(table);
+    Memory_release(atomic_load_explicit(&table->index_, memory_order_relaxed));
+    for(unsigned int i = 0; i < ConcurrentHashTable_Stripes; i++) mtx_destroy(&table->stripes_[i].lock);
+    mtx_destroy(&table->reclaim_lock_);
+    mtx_destroy(&table->retire_lock_);
+}
+
+ConcurrentHashTable* ConcurrentHashTable_create(
+    size_t lines,
+    unsigned int (*hash)(const void* target_),
+    int (*compare)(const void* lhs_, const void* rhs_)
+){
+    Profile_allocating_(ProfileKind_ConcurrentHashTable);
+    ConcurrentHashTable* table = (ConcurrentHashTable*)Memory_allocate_aligned(
+        sizeof(ConcurrentHashTable), alignof(ConcurrentHashTable)
+    );
+    size_t rounded_lines = ConcurrentHashTable_Stripes;
+    while(rounded_lines < lines) rounded_lines <<= 1;
+    atomic_init(&table->index_, ConcurrentHashTable_allocate_index_(rounded_lines));
+    table->hash_ = hash;
+    table->compare_ = compare;
+    for(unsigned int i = 0; i < ConcurrentHashTable_Stripes; i++){
+        mtx_init(&table->stripes_[i].lock, mtx_plain);
+        table->stripes_[i].size = 0;
+    }
+    for(unsigned int i = 0; i < ConcurrentHashTable_ReaderSlots; i++){
+        atomic_init(table->readers_[i].readers, 0);
+        atomic_init(table->readers_[i].readers + 1, 0);
+    }
+    atomic_init(&table->epoch_, 0);
+    mtx_init(&table->reclaim_lock_, mtx_plain);
+    mtx_init(&table->retire_lock_, mtx_plain);
+    table->retired_ = NULL;
+    table->retired_count_ = 0;
+    RAII_set_deleter(table, (void(*)(void*))ConcurrentHashTable_destroy_);
+    return table;
+}
+
+void ConcurrentHashTable_clear(ConcurrentHashTable* table){
+    ConcurrentHashTable_reclaim_(table);
+    ConcurrentHashTableIndex_* index = atomic_load_explicit(&table->index_, memory_order_relaxed);
+    for(size_t i = 0; i < index->lines; i++){
+        ConcurrentHashTableNode_* node = atomic_load_explicit(index->heads + i, memory_order_relaxed);
+        while(node != NULL){
+            ConcurrentHashTableNode_* next = atomic_load_explicit(&node->next, memory_order_relaxed);
+            ConcurrentHashTable_release_node_(node);
+            node = next;
+        }
+        atomic_store_explicit(index->heads + i, NULL, memory_order_relaxed);
+    }
+    for(unsigned int i = 0; i < ConcurrentHashTable_Stripes; i++) table->stripes_[i].size = 0;
+}
+
+size_t ConcurrentHashTable_size(ConcurrentHashTable* table){
+    size_t size = 0;
+    for(unsigned int i = 0; i < ConcurrentHashTable_Stripes; i++){
+        mtx_lock(&table->stripes_[i].lock);
+        size += table->stripes_[i].size;
+        mtx_unlock(&table->stripes_[i].lock);
+    }
+    return size;
+}
+
+unsigned int ConcurrentHashTable_read_lock(ConcurrentHashTable* table){
+    atomic_size_t* readers = table->readers_[ConcurrentHashTable_reader_slot_()].readers;
+    ConcurrentHashTable_read_depth_ += 1;
+    while(true){
+        const unsigned int epoch = atomic_load_explicit(&table->epoch_, memory_order_seq_cst);
+        atomic_fetch_add_explicit(readers + (epoch & 1), 1, memory_order_seq_cst);
+        // registered under a stale parity if a reclamation started meanwhile, which may not wait for us
+        if(atomic_load_explicit(&table->epoch_, memory_order_seq_cst) == epoch) return epoch & 1;
+        atomic_fetch_sub_explicit(readers + (epoch & 1), 1, memory_order_seq_cst);
+    }
+}
+
+void ConcurrentHashTable_read_unlock(ConcurrentHashTable* table, unsigned int token){
+    atomic_size_t* readers = table->readers_[ConcurrentHashTable_reader_slot_()].readers;
+    atomic_fetch_sub_explicit(readers + token, 1, memory_order_release);
+    ConcurrentHashTable_read_depth_ -= 1;
+}
+
+KeyValue* ConcurrentHashTable_find(ConcurrentHashTable* table, void* key){
+    Profile_operation_(ProfileKind_ConcurrentHashTable);
+    const unsigned int hash = table->hash_(key);
+    KeyValue* result = NULL;
+    const unsigned int token = ConcurrentHashTable_read_lock(table);
+    ConcurrentHashTableIndex_* index = atomic_load_explicit(&table->index_, memory_order_acquire);
+    ConcurrentHashTableNode_* node = atomic_load_explicit(
+        index->heads + (hash & (index->lines - 1)), memory_order_acquire
+    );
+    for(; node != NULL; node = atomic_load_explicit(&node->next, memory_order_acquire)){
+        if(node->hash == hash && table->compare_(key, node->entry->key) == 0){
+            result = node->entry;
+            break;
+        }
+    }
+    ConcurrentHashTable_read_unlock(table, token);
+    return result;
+}
+
+bool ConcurrentHashTable_insert(
+    ConcurrentHashTable* table, void* key, bool owns_key, void* value, bool owns_value,
+    KeyValue** result
+){
+    Profile_operation_(ProfileKind_ConcurrentHashTable);
+    const unsigned int hash = table->hash_(key);
+    ConcurrentHashTableStripe_* stripe = ConcurrentHashTable_stripe_(table, hash);
+    mtx_lock(&stripe->lock);
+    // index is replaced only with all stripes locked, it cannot change while holding one
+    ConcurrentHashTableIndex_* index = atomic_load_explicit(&table->index_, memory_order_relaxed);
+    _Atomic(ConcurrentHashTableNode_*)* head = index->heads + (hash & (index->lines - 1));
+    ConcurrentHashTableNode_* node = atomic_load_explicit(head, memory_order_relaxed);
+    for(; node != NULL; node = atomic_load_explicit(&node->next, memory_order_relaxed)){
+        if(node->hash == hash && table->compare_(key, node->entry->key) == 0){
+            if(result != NULL) *result = node->entry;
+            mtx_unlock(&stripe->lock);
+            return false;
+        }
+    }
+    Profile_allocating_(ProfileKind_ConcurrentHashTable);
+    node = (ConcurrentHashTableNode_*)Memory_allocate_object(sizeof(ConcurrentHashTableNode_));
+    node->entry = KeyValue_create(key, owns_key, value, owns_value);
+    node->hash = hash;
+    atomic_init(&node->next, atomic_load_explicit(head, memory_order_relaxed));
+    // publish the node only after it is fully set up
+    atomic_store_explicit(head, node, memory_order_release);
+    stripe->size += 1;
+    if(result != NULL) *result = node->entry;
+    const bool overloaded = stripe->size
+                            > index->lines / ConcurrentHashTable_Stripes * ConcurrentHashTable_MaxLoadFactor;
+    mtx_unlock(&stripe->lock);
+    if(overloaded) ConcurrentHashTable_grow_(table, index);
+    return true;
+}
+
+bool ConcurrentHashTable_erase(ConcurrentHashTable* table, void* key){
+    Profile_operation_(ProfileKind_ConcurrentHashTable);
+    const unsigned int hash = table->hash_(key);
+    ConcurrentHashTableStripe_* stripe = ConcurrentHashTable_stripe_(table, hash);
+    mtx_lock(&stripe->lock);
+    ConcurrentHashTableIndex_* index = atomic_load_explicit(&table->index_, memory_order_relaxed);
+    _Atomic(ConcurrentHashTableNode_*)* link = index->heads + (hash & (index->lines - 1));
+    ConcurrentHashTableNode_* node = atomic_load_explicit(link, memory_order_relaxed);
+    for(; node != NULL; link = &node->next, node = atomic_load_explicit(link, memory_order_relaxed)){
+        if(node->hash == hash && table->compare_(key, node->entry->key) == 0) break;
+    }
+    if(node != NULL){
+        // readers standing on the node can still follow its link, which is left intact
+        atomic_store_explicit(link, atomic_load_explicit(&node->next, memory_order_relaxed), memory_order_release);
+        stripe->size -= 1;
+    }
+    mtx_unlock(&stripe->lock);
+    if(node == NULL) return false;
+    ConcurrentHashTable_retire_(table, node, ConcurrentHashTable_release_node_);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef CxKANOAXDP_concurrent_hashtable_H_
+#define CxKANOAXDP_concurrent_hashtable_H_
+#include "keyvalue_pair.h"
+#include <stdbool.h>
+#include <stddef.h>
+// hash table which may be accessed from multiple threads at the same time
+//  lookups take no lock: they run inside read-side critical sections, and memory unlinked by writers is
+//  reclaimed only after all critical sections that might still see it have ended. Insertions and removals
+//  lock one of a fixed set of stripes, each covering a subset of lines. Growing locks all stripes, copies the
+//  chains to a new index and publishes it, while lookups continue on the old index undisturbed
+//  insertions and removals on all threads therefore pause while the table grows, for time linear to its size,
+//   which is amortized over the insertions doubling it. Tables where such pauses matter should be created with
+//   enough lines for the entries expected
+//  unlike HashTable, keys are unique in the table
+typedef struct ConcurrentHashTable ConcurrentHashTable;
+
+// create a new concurrent hash table
+//  lines is rounded up to a power of 2, and to no less than the number of stripes
+ConcurrentHashTable* ConcurrentHashTable_create(
+    size_t lines,
+    unsigned int (*hash)(const void* target_),
+    int (*compare)(const void* lhs_, const void* rhs_)
+);
+
+// remove all entries from table, must not be called concurrently with any other operation
+void ConcurrentHashTable_clear(ConcurrentHashTable* table);
+
+// get number of entries in table, which may be outdated once returned if the table is being modified
+size_t ConcurrentHashTable_size(ConcurrentHashTable* table);
+
+// enter a read-side critical section, entries found within it stay accessible until it is left even if
+//  removed concurrently. Critical sections may be nested and may contain insertions and removals, but should
+//  be short, since they hold back reclamation of memory for the whole table
+//  return token to be passed to ConcurrentHashTable_read_unlock
+unsigned int ConcurrentHashTable_read_lock(ConcurrentHashTable* table);
+
+// leave a read-side critical section
+void ConcurrentHashTable_read_unlock(ConcurrentHashTable* table, unsigned int token);
+
+// lookup entry within table without locking
+//  the entry returned stays accessible until it is removed, or until the enclosing read-side critical
+//   section ends if it may be removed concurrently
+KeyValue* ConcurrentHashTable_find(ConcurrentHashTable* table, void* key);
+
+// insert a new entry to table if no entry with same key exists
+//  ownership of key and value is specified in the same way as HashTable_insert
+//  result receives the entry inserted or the one already with key if not NULL, in the same way as
+//   ConcurrentHashTable_find
+//  return if the entry is inserted
+bool ConcurrentHashTable_insert(
+    ConcurrentHashTable* table, void* key, bool owns_key, void* value, bool owns_value,
+    KeyValue** result
+);
+
+// remove the entry with specified key, return if an entry is removed
+//  the entry is destroyed once no read-side critical section may access it
+bool ConcurrentHashTable_erase(ConcurrentHashTable* table, void* key);
+#endif
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "concurrent_heap.h"
+#include "heap.h"
+#include "memory.h"
+#include "profile.h"
+#include "RAII.h"
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <threads.h>
+#include <unistd.h>
+enum ConcurrentHeap_Constant{
+    ConcurrentHeap_CacheLine = 64,          // size of cache line, used to keep shards apart
+    ConcurrentHeap_ShardsPerProcessor = 2,  // default number of shards for each online processor
+    ConcurrentHeap_LockAttempts = 4,        // attempts to lock a random shard before waiting on one
+    ConcurrentHeap_PopAttempts = 8,         // attempts to pop from random shards before sweeping all of them
+};
+// a heap along with the lock protecting it, kept on its own cache lines
+typedef struct{
+    alignas(ConcurrentHeap_CacheLine) mtx_t lock;
+    Heap* heap;
+    // number of elements in heap, written under lock but may be read without it
+    atomic_size_t size;
+}ConcurrentHeapShard_;
+struct ConcurrentHeap{
+    RAII _;
+    ConcurrentHeapShard_* shards_;
+    unsigned int shard_count_;
+    int (*compare_)(const void* lhs_, const void* rhs_);
+};
+
+// pick a random shard, using a generator local to the calling thread
+static ConcurrentHeapShard_* ConcurrentHeap_random_shard_(ConcurrentHeap* heap){
+    static _Thread_local uint32_t state = 0;
+    if(state == 0){
+        // seed with the address of the state which differs among threads
+        state = (uint32_t)(((uintptr_t)&state * 0x9E3779B97F4A7C15ull) >> 32) | 1u;
+    }
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return heap->shards_ + state % heap->shard_count_;
+}
+
+// remove the top element of a locked shard
+static void ConcurrentHeap_pop_locked_(ConcurrentHeapShard_* shard, void** key, void** value){
+    Heap_pop_into(shard->heap, key, value);
+    atomic_store_explicit(&shard->size, Heap_size(shard->heap), memory_order_relaxed);
+}
+
+// destroy the heap
+static void ConcurrentHeap_destroy_(ConcurrentHeap* heap){
+    for(unsigned int i = 0; i < heap->shard_count_; i++){
+        RAII_delete(heap->shards_[i].heap);
+        mtx_destroy(&heap->shards_[i].lock);
+    }
+    Memory_release(heap->shards_);
+}
+
+ConcurrentHeap* ConcurrentHeap_create(int (*compare)(const void* lhs_, const void* rhs_), unsigned int shards){
+    if(shards == 0){
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        shards = (processors > 0 ? processors : 1) * ConcurrentHeap_ShardsPerProcessor;
+    }
+    Profile_allocating_(ProfileKind_ConcurrentHeap);
+    ConcurrentHeap* heap = (ConcurrentHeap*)Memory_allocate_object(sizeof(ConcurrentHeap));
+    Profile_allocating_(ProfileKind_ConcurrentHeap);
+    heap->shards_ = (ConcurrentHeapShard_*)Memory_allocate_aligned(
+        sizeof(ConcurrentHeapShard_) * shards, alignof(ConcurrentHeapShard_)
+    );
+    heap->shard_count_ = shards;
+    heap->compare_ = compare;
+    for(unsigned int i = 0; i < shards; i++){
+        mtx_init(&heap->shards_[i].lock, mtx_plain);
+        heap->shards_[i].heap = Heap_create(compare);
+        atomic_init(&heap->shards_[i].size, 0);
+    }
+    RAII_set_deleter(heap, (void(*)(void*))ConcurrentHeap_destroy_);
+    return heap;
+}
+
+void ConcurrentHeap_clear(ConcurrentHeap* heap){
+    for(unsigned int i = 0; i < heap->shard_count_; i++){
+        Heap_clear(heap->shards_[i].heap);
+        atomic_store_explicit(&heap->shards_[i].size, 0, memory_order_relaxed);
+    }
+}
+
+size_t ConcurrentHeap_size(ConcurrentHeap* heap){
+    size_t size = 0;
+    for(unsigned int i = 0; i < heap->shard_count_; i++){
+        size += atomic_load_explicit(&heap->shards_[i].size, memory_order_relaxed);
+    }
+    return size;
+}
+
+void ConcurrentHeap_insert(ConcurrentHeap* heap, void* key, bool owns_key, void* value, bool owns_value){
+    Profile_operation_(ProfileKind_ConcurrentHeap);
+    ConcurrentHeapShard_* shard = NULL;
+    ConcurrentHeapShard_* candidate = NULL;
+    for(unsigned int attempt = 0; attempt < ConcurrentHeap_LockAttempts; attempt++){
+        candidate = ConcurrentHeap_random_shard_(heap);
+        if(mtx_trylock(&candidate->lock) == thrd_success){
+            shard = candidate;
+            break;
+        }
+    }
+    if(shard == NULL){
+        // all shards tried are busy, wait for the last one
+        shard = candidate;
+        mtx_lock(&shard->lock);
+    }
+    Heap_insert(shard->heap, key, owns_key, value, owns_value);
+    atomic_store_explicit(&shard->size, Heap_size(shard->heap), memory_order_relaxed);
+    mtx_unlock(&shard->lock);
+}
+
+bool ConcurrentHeap_try_pop(ConcurrentHeap* heap, void** key, void** value){
+    Profile_operation_(ProfileKind_ConcurrentHeap);
+    for(unsigned int attempt = 0; attempt < ConcurrentHeap_PopAttempts; attempt++){
+        ConcurrentHeapShard_* candidates[2] = {
+            ConcurrentHeap_random_shard_(heap), ConcurrentHeap_random_shard_(heap)
+        };
+        ConcurrentHeapShard_* locked[2];
+        unsigned int locked_count = 0;
+        for(unsigned int i = 0; i < 2; i++){
+            if(i == 1 && candidates[1] == candidates[0]) break;
+            if(atomic_load_explicit(&candidates[i]->size, memory_order_relaxed) == 0) continue;
+            // never wait here: holding one lock while waiting for another may deadlock
+            if(mtx_trylock(&candidates[i]->lock) == thrd_success) locked[locked_count++] = candidates[i];
+        }
+        // take the better top among the shards locked
+        ConcurrentHeapShard_* best = NULL;
+        for(unsigned int i = 0; i < locked_count; i++){
+            KeyValue* top = Heap_top_entry(locked[i]->heap);
+            if(top == NULL) continue;
+            if(best == NULL || heap->compare_(top->key, Heap_top_entry(best->heap)->key) < 0) best = locked[i];
+        }
+        if(best != NULL) ConcurrentHeap_pop_locked_(best, key, value);
+        for(unsigned int i = 0; i < locked_count; i++) mtx_unlock(&locked[i]->lock);
+        if(best != NULL) return true;
+    }
+    // random shards keep failing, the heap is likely to be (nearly) empty, look through all shards
+    for(unsigned int i = 0; i < heap->shard_count_; i++){
+        ConcurrentHeapShard_* shard = heap->shards_ + i;
+        if(atomic_load_explicit(&shard->size, memory_order_relaxed) == 0) continue;
+        mtx_lock(&shard->lock);
+        bool found = Heap_size(shard->heap) != 0;
+        if(found) ConcurrentHeap_pop_locked_(shard, key, value);
+        mtx_unlock(&shard->lock);
+        if(found) return true;
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef CxKANOAXDP_concurrent_heap_H_
+#define CxKANOAXDP_concurrent_heap_H_
+#include <stdbool.h>
+#include <stddef.h>
+// priority queue which may be accessed from multiple threads at the same time
+//  elements are spread over several independently locked heaps (shards), in the way of a MultiQueue. A pop
+//  takes the better top of two randomly chosen shards, therefore the order is relaxed: the element removed
+//  is not necessarily the top of the whole queue but is very likely among the first few of it
+typedef struct ConcurrentHeap ConcurrentHeap;
+
+// create a new concurrent heap
+//  compare specifies the order by which the elements are arranged
+//  shards specifies the number of internal heaps, passing 0 selects twice the number of online processors
+ConcurrentHeap* ConcurrentHeap_create(int (*compare)(const void* lhs_, const void* rhs_), unsigned int shards);
+
+// remove all elements from heap, must not be called concurrently with any other operation
+void ConcurrentHeap_clear(ConcurrentHeap* heap);
+
+// get number of elements in heap, which may be outdated once returned if the heap is being modified
+size_t ConcurrentHeap_size(ConcurrentHeap* heap);
+
+// insert a new element to heap, may be called from multiple threads
+//  ownership of key and value is specified in the same way as Heap_insert
+void ConcurrentHeap_insert(ConcurrentHeap* heap, void* key, bool owns_key, void* value, bool owns_value);
+
+// remove an element near the top of heap, may be called from multiple threads
+//  key and value are handed to the caller in the same way as Heap_pop_into
+//  return false if no element was found, which is reliable only if no insertion is running concurrently
+bool ConcurrentHeap_try_pop(ConcurrentHeap* heap, void** key, void** value);
+#endif
\ No newline at end of file
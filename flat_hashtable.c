@@ -0,0 +1,257 @@
+#include "flat_hashtable.h"
+#include "bitops.h"
+#include "memory.h"
+#include "profile.h"
+#include "RAII.h"
+#include <stdalign.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+enum FlatHashTable_Constant{
+    FlatHashTable_GroupSize = 16,       // slots probed at once
+    FlatHashTable_MaxLoadNumerator = 7, // maximum load factor is 7/8
+    FlatHashTable_MaxLoadDenominator = 8,
+};
+// values of control bytes, any value with the highest bit clear is the hash tag of a full slot
+enum FlatHashTable_Control{
+    FlatHashTable_Empty = 0x80,
+    FlatHashTable_Deleted = 0xFE,
+};
+struct FlatHashTable{
+    RAII _;
+    // control bytes of all slots, followed by the slots in the same allocation
+    unsigned char* control_;
+    unsigned char* slots_;
+    size_t capacity_;
+    size_t size_;
+    // slots marked deleted, which still lengthen probe sequences
+    size_t deleted_;
+    size_t key_size_;
+    size_t value_size_;
+    // offset of value within a slot and size of a slot
+    size_t value_offset_;
+    size_t slot_size_;
+    // 63 less log2 of number of groups, by which hashes shifted right once more are shifted to get home groups
+    unsigned int shift_;
+    unsigned int (*hash_)(const void* key);
+    int (*compare_)(const void* lhs_, const void* rhs_);
+};
+
+// get the alignment a type of specified size may require at most
+static inline size_t FlatHashTable_alignment_(size_t size){
+    size_t alignment = size & (~size + 1);
+    return alignment == 0 || alignment > alignof(max_align_t) ? alignof(max_align_t) : alignment;
+}
+
+// round size up to a multiple of alignment, which must be a power of 2
+static inline size_t FlatHashTable_align_(size_t size, size_t alignment){
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+// spread the hash given by user over higher bits by Fibonacci hashing
+//  a multiplication only carries bits upwards, so home groups are taken from the highest bits and tags from
+//   the lowest bits of the upper half, both of which depend on every bit of the hash given by user. Therefore
+//   weak hash functions, even identity on keys of regular strides, still probe well
+static inline uint64_t FlatHashTable_hash_(FlatHashTable* table, const void* key){
+    return (uint64_t)table->hash_(key) * UINT64_C(0x9E3779B97F4A7C15);
+}
+
+// get the 7 bits of hash stored in control byte
+static inline unsigned char FlatHashTable_tag_(uint64_t hash){
+    return (hash >> 32) & 0x7F;
+}
+
+// get the group probing for hash starts from
+//  shifted in two steps so that a table of a single group, which takes no bits, shifts by no more than 63
+static inline size_t FlatHashTable_home_(FlatHashTable* table, uint64_t hash){
+    return (size_t)((hash >> 1) >> table->shift_);
+}
+
+// get mask of slots in a group whose control byte equals value, bit i for the i-th slot
+static inline unsigned int FlatHashTable_match_(const unsigned char* group, unsigned char value){
+    #if defined(__SSE2__)
+    __m128i control = _mm_loadu_si128((const __m128i*)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8((char)value)));
+    #else
+    unsigned int mask = 0;
+    for(unsigned int i = 0; i < FlatHashTable_GroupSize; i++) mask |= (unsigned int)(group[i] == value) << i;
+    return mask;
+    #endif
+}
+
+// get pointer to the key in specified slot
+static inline unsigned char* FlatHashTable_slot_(FlatHashTable* table, size_t index){
+    return table->slots_ + index * table->slot_size_;
+}
+
+// compare two keys for equality
+static inline bool FlatHashTable_equal_(FlatHashTable* table, const void* lhs, const void* rhs){
+    if(table->compare_ == NULL) return memcmp(lhs, rhs, table->key_size_) == 0;
+    return table->compare_(lhs, rhs) == 0;
+}
+
+// allocate control bytes and slots for specified capacity, all slots empty
+static void FlatHashTable_allocate_(FlatHashTable* table, size_t capacity){
+    const size_t slots_offset = FlatHashTable_align_(capacity, alignof(max_align_t));
+    Profile_allocating_(ProfileKind_FlatHashTable);
+    table->control_ = (unsigned char*)Memory_allocate(slots_offset + capacity * table->slot_size_);
+    table->slots_ = table->control_ + slots_offset;
+    table->capacity_ = capacity;
+    table->size_ = 0;
+    table->deleted_ = 0;
+    table->shift_ = 63;
+    for(size_t groups = capacity / FlatHashTable_GroupSize; groups > 1; groups >>= 1) table->shift_ -= 1;
+    memset(table->control_, FlatHashTable_Empty, capacity);
+}
+
+// find slot holding specified key
+//  return index of the slot, or capacity if not found
+static size_t FlatHashTable_locate_(FlatHashTable* table, const void* key, uint64_t hash){
+    const size_t group_mask = table->capacity_ / FlatHashTable_GroupSize - 1;
+    const unsigned char tag = FlatHashTable_tag_(hash);
+    size_t group = FlatHashTable_home_(table, hash);
+    for(size_t step = 1; ; step++){
+        const unsigned char* control = table->control_ + group * FlatHashTable_GroupSize;
+        for(unsigned int match = FlatHashTable_match_(control, tag); match != 0; match &= match - 1){
+            const size_t index = group * FlatHashTable_GroupSize + BitOps_trailing_zeros(match);
+            if(FlatHashTable_equal_(table, key, FlatHashTable_slot_(table, index))) return index;
+        }
+        // probe sequence ends at the first group with an empty slot
+        if(FlatHashTable_match_(control, FlatHashTable_Empty) != 0) return table->capacity_;
+        // triangular probing visits each group exactly once since the number of groups is a power of 2
+        group = (group + step) & group_mask;
+        if(step > group_mask) return table->capacity_;
+    }
+}
+
+// find a slot that is empty or deleted to put a new entry with specified hash
+static size_t FlatHashTable_vacancy_(FlatHashTable* table, uint64_t hash){
+    const size_t group_mask = table->capacity_ / FlatHashTable_GroupSize - 1;
+    size_t group = FlatHashTable_home_(table, hash);
+    for(size_t step = 1; ; step++){
+        const unsigned char* control = table->control_ + group * FlatHashTable_GroupSize;
+        const unsigned int vacancies = FlatHashTable_match_(control, FlatHashTable_Empty)
+                                       | FlatHashTable_match_(control, FlatHashTable_Deleted);
+        if(vacancies != 0) return group * FlatHashTable_GroupSize + BitOps_trailing_zeros(vacancies);
+        group = (group + step) & group_mask;
+    }
+}
+
+// move all entries to newly allocated slots of specified capacity, dropping deleted slots
+static void FlatHashTable_rehash_(FlatHashTable* table, size_t capacity){
+    unsigned char* old_control = table->control_;
+    unsigned char* old_slots = table->slots_;
+    const size_t old_capacity = table->capacity_;
+    const size_t size = table->size_;
+    FlatHashTable_allocate_(table, capacity);
+    for(size_t i = 0; i < old_capacity; i++){
+        if(old_control[i] & 0x80) continue;
+        const unsigned char* slot = old_slots + i * table->slot_size_;
+        const uint64_t hash = FlatHashTable_hash_(table, slot);
+        const size_t index = FlatHashTable_vacancy_(table, hash);
+        table->control_[index] = FlatHashTable_tag_(hash);
+        memcpy(FlatHashTable_slot_(table, index), slot, table->slot_size_);
+    }
+    table->size_ = size;
+    Memory_release(old_control);
+}
+
+// get capacity large enough to hold count entries without exceeding the maximum load factor
+static size_t FlatHashTable_capacity_for_(size_t count){
+    size_t capacity = FlatHashTable_GroupSize;
+    while(capacity / FlatHashTable_MaxLoadDenominator * FlatHashTable_MaxLoadNumerator < count) capacity <<= 1;
+    return capacity;
+}
+
+// destroy the table
+static void FlatHashTable_destroy_(FlatHashTable* table){
+    Memory_release(table->control_);
+}
+
+FlatHashTable* FlatHashTable_create(
+    size_t key_size,
+    size_t value_size,
+    unsigned int (*hash)(const void* target_),
+    int (*compare)(const void* lhs_, const void* rhs_)
+){
+    Profile_allocating_(ProfileKind_FlatHashTable);
+    FlatHashTable* table = (FlatHashTable*)Memory_allocate_object(sizeof(FlatHashTable));
+    const size_t key_alignment = FlatHashTable_alignment_(key_size);
+    const size_t value_alignment = value_size == 0 ? 1 : FlatHashTable_alignment_(value_size);
+    table->key_size_ = key_size;
+    table->value_size_ = value_size;
+    table->value_offset_ = FlatHashTable_align_(key_size, value_alignment);
+    table->slot_size_ = FlatHashTable_align_(
+        table->value_offset_ + value_size, key_alignment > value_alignment ? key_alignment : value_alignment
+    );
+    table->hash_ = hash;
+    table->compare_ = compare;
+    FlatHashTable_allocate_(table, FlatHashTable_GroupSize);
+    RAII_set_deleter(table, (void(*)(void*))FlatHashTable_destroy_);
+    return table;
+}
+
+void FlatHashTable_clear(FlatHashTable* table){
+    memset(table->control_, FlatHashTable_Empty, table->capacity_);
+    table->size_ = 0;
+    table->deleted_ = 0;
+}
+
+size_t FlatHashTable_size(FlatHashTable* table){
+    return table->size_;
+}
+
+void FlatHashTable_reserve(FlatHashTable* table, size_t count){
+    const size_t capacity = FlatHashTable_capacity_for_(count);
+    if(capacity > table->capacity_) FlatHashTable_rehash_(table, capacity);
+}
+
+void* FlatHashTable_find(FlatHashTable* table, const void* key){
+    Profile_operation_(ProfileKind_FlatHashTable);
+    const size_t index = FlatHashTable_locate_(table, key, FlatHashTable_hash_(table, key));
+    if(index == table->capacity_) return NULL;
+    return FlatHashTable_slot_(table, index) + table->value_offset_;
+}
+
+bool FlatHashTable_insert(FlatHashTable* table, const void* key, const void* value, void** result){
+    Profile_operation_(ProfileKind_FlatHashTable);
+    uint64_t hash = FlatHashTable_hash_(table, key);
+    size_t index = FlatHashTable_locate_(table, key, hash);
+    if(index != table->capacity_){
+        if(result != NULL) *result = FlatHashTable_slot_(table, index) + table->value_offset_;
+        return false;
+    }
+    const size_t limit = table->capacity_ / FlatHashTable_MaxLoadDenominator * FlatHashTable_MaxLoadNumerator;
+    if(table->size_ + table->deleted_ + 1 > limit){
+        // reclaim deleted slots in place if they make up much of the load, grow otherwise
+        FlatHashTable_rehash_(table, table->size_ + 1 > limit / 2 ? table->capacity_ << 1 : table->capacity_);
+    }
+    index = FlatHashTable_vacancy_(table, hash);
+    if(table->control_[index] == FlatHashTable_Deleted) table->deleted_ -= 1;
+    table->control_[index] = FlatHashTable_tag_(hash);
+    unsigned char* slot = FlatHashTable_slot_(table, index);
+    memcpy(slot, key, table->key_size_);
+    if(value != NULL) memcpy(slot + table->value_offset_, value, table->value_size_);
+    else memset(slot + table->value_offset_, 0, table->value_size_);
+    table->size_ += 1;
+    if(result != NULL) *result = slot + table->value_offset_;
+    return true;
+}
+
+bool FlatHashTable_erase(FlatHashTable* table, const void* key){
+    Profile_operation_(ProfileKind_FlatHashTable);
+    const size_t index = FlatHashTable_locate_(table, key, FlatHashTable_hash_(table, key));
+    if(index == table->capacity_) return false;
+    // a probe sequence reaching this group stops here anyway if the group has an empty slot
+    const unsigned char* group = table->control_ + index / FlatHashTable_GroupSize * FlatHashTable_GroupSize;
+    if(FlatHashTable_match_(group, FlatHashTable_Empty) != 0){
+        table->control_[index] = FlatHashTable_Empty;
+    }else{
+        table->control_[index] = FlatHashTable_Deleted;
+        table->deleted_ += 1;
+    }
+    table->size_ -= 1;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef CxKANOAXDP_flat_hashtable_H_
+#define CxKANOAXDP_flat_hashtable_H_
+#include <stdbool.h>
+#include <stddef.h>
+// hash table with open addressing storing keys and values of fixed size inline
+//  each slot has a control byte holding 7 bits of the hash of its key, which are compared for 16 slots at
+//  once (with SSE2 where available) before any key is compared, therefore a lookup rarely compares keys
+//  other than the one it is looking for and touches very few cache lines
+//  keys and values are copied byte by byte into the table and are not managed, they shall be plain data
+typedef struct FlatHashTable FlatHashTable;
+
+// create a new flat hash table
+//  key_size and value_size specify size of each key and value in bytes, value_size may be 0 to make a set
+//  compare may be NULL, in which case keys are compared byte by byte
+FlatHashTable* FlatHashTable_create(
+    size_t key_size,
+    size_t value_size,
+    unsigned int (*hash)(const void* target_),
+    int (*compare)(const void* lhs_, const void* rhs_)
+);
+
+// remove all entries from table, keeping the space allocated
+void FlatHashTable_clear(FlatHashTable* table);
+
+// get number of entries in table
+inline size_t FlatHashTable_size(FlatHashTable* table);
+
+// make room for at least count entries without growing again
+void FlatHashTable_reserve(FlatHashTable* table, size_t count);
+
+// lookup entry with specified key
+//  return pointer to the value stored in table, which is valid until next insertion, or NULL if not found
+void* FlatHashTable_find(FlatHashTable* table, const void* key);
+
+// insert a new entry to table if no entry with same key exists
+//  value may be NULL, in which case the value stored is filled with zero
+//  result receives pointer to the value stored with key if not NULL, in the same way as FlatHashTable_find
+//  return if the entry is inserted
+bool FlatHashTable_insert(FlatHashTable* table, const void* key, const void* value, void** result);
+
+// remove the entry with specified key, return if an entry is removed
+bool FlatHashTable_erase(FlatHashTable* table, const void* key);
+#endif
\ No newline at end of file
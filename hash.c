@@ -0,0 +1,167 @@
+#include "hash.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+#if defined(__linux__)
+#include <sys/random.h>
+#endif
+// constants for mixing, odd numbers with balanced bits
+static const uint64_t Hash_secret_[4] = {
+    UINT64_C(0x2d358dccaa6c78a5), UINT64_C(0x8bb84b93962eacc9),
+    UINT64_C(0x4b33a62ed433d4a3), UINT64_C(0x4d5a2da51de1aa47),
+};
+static once_flag Hash_seed_once_ = ONCE_FLAG_INIT;
+static uint64_t Hash_seed_;
+
+// multiply two integers into 128 bits, storing the lower half in lhs and the higher half in rhs
+static inline void Hash_multiply_(uint64_t* lhs, uint64_t* rhs){
+    #if defined(__SIZEOF_INT128__)
+    __extension__ const unsigned __int128 product = (unsigned __int128)*lhs * *rhs;
+    *lhs = (uint64_t)product;
+    *rhs = (uint64_t)(product >> 64);
+    #else
+    const uint64_t lhs_high = *lhs >> 32, lhs_low = (uint32_t)*lhs;
+    const uint64_t rhs_high = *rhs >> 32, rhs_low = (uint32_t)*rhs;
+    const uint64_t high_high = lhs_high * rhs_high, high_low = lhs_high * rhs_low;
+    const uint64_t low_high = lhs_low * rhs_high, low_low = lhs_low * rhs_low;
+    const uint64_t middle = (low_low >> 32) + (uint32_t)high_low + (uint32_t)low_high;
+    *lhs = (middle << 32) | (uint32_t)low_low;
+    *rhs = high_high + (high_low >> 32) + (low_high >> 32) + (middle >> 32);
+    #endif
+}
+
+// multiply as Hash_multiply_, then fold each operand back into its half
+//  an operand forced to 0 by crafted input would otherwise wipe out the other one, along with the seed
+static inline void Hash_multiply_protected_(uint64_t* lhs, uint64_t* rhs){
+    const uint64_t lhs_operand = *lhs, rhs_operand = *rhs;
+    Hash_multiply_(lhs, rhs);
+    *lhs ^= lhs_operand;
+    *rhs ^= rhs_operand;
+}
+
+// multiply two integers into 128 bits and fold the halves together
+static inline uint64_t Hash_mix_(uint64_t lhs, uint64_t rhs){
+    Hash_multiply_protected_(&lhs, &rhs);
+    return lhs ^ rhs;
+}
+
+static inline uint64_t Hash_read64_(const unsigned char* data){
+    uint64_t result;
+    memcpy(&result, data, sizeof(result));
+    return result;
+}
+
+static inline uint64_t Hash_read32_(const unsigned char* data){
+    uint32_t result;
+    memcpy(&result, data, sizeof(result));
+    return result;
+}
+
+// read 1 to 3 bytes, covering first, middle and last of them
+static inline uint64_t Hash_read_short_(const unsigned char* data, size_t length){
+    return ((uint64_t)data[0] << 16) | ((uint64_t)data[length >> 1] << 8) | data[length - 1];
+}
+
+// fill seed from the random source of the system, return if succeeded
+static bool Hash_seed_system_(uint64_t* seed){
+    #if defined(__linux__)
+    if(getrandom(seed, sizeof(*seed), 0) == (ssize_t)sizeof(*seed)) return true;
+    #endif
+    FILE* stream = fopen("/dev/urandom", "rb");
+    if(stream == NULL) return false;
+    const bool success = fread(seed, sizeof(*seed), 1, stream) == 1;
+    fclose(stream);
+    return success;
+}
+
+// take the seed from the system, or gather whatever entropy is at hand where there is no random source
+static void Hash_seed_initialize_(void){
+    if(Hash_seed_system_(&Hash_seed_)) return;
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    uint64_t seed = Hash_mix_((uint64_t)now.tv_sec ^ Hash_secret_[0], (uint64_t)now.tv_nsec ^ Hash_secret_[1]);
+    // addresses differ between runs where address space layout is randomized
+    seed = Hash_mix_(seed ^ (uint64_t)(uintptr_t)&now, (uint64_t)(uintptr_t)&Hash_seed_ ^ Hash_secret_[2]);
+    seed = Hash_mix_(seed ^ (uint64_t)clock(), Hash_secret_[3]);
+    Hash_seed_ = seed;
+}
+
+uint64_t Hash_seed(void){
+    call_once(&Hash_seed_once_, Hash_seed_initialize_);
+    return Hash_seed_;
+}
+
+uint64_t Hash_bytes(const void* data, size_t length, uint64_t seed){
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t a, b;
+    seed ^= Hash_mix_(seed ^ Hash_secret_[0], Hash_secret_[1]);
+    if(length <= 16){
+        if(length >= 4){
+            // two overlapping pairs of 4 bytes cover anything from 4 to 16 bytes
+            const size_t shift = (length >> 3) << 2;
+            a = (Hash_read32_(bytes) << 32) | Hash_read32_(bytes + shift);
+            b = (Hash_read32_(bytes + length - 4) << 32) | Hash_read32_(bytes + length - 4 - shift);
+        }else if(length > 0){
+            a = Hash_read_short_(bytes, length);
+            b = 0;
+        }else{
+            a = b = 0;
+        }
+    }else{
+        size_t remaining = length;
+        if(remaining > 48){
+            // three independent lanes keep the multipliers busy
+            uint64_t lane1 = seed, lane2 = seed;
+            do{
+                seed = Hash_mix_(Hash_read64_(bytes) ^ Hash_secret_[1], Hash_read64_(bytes + 8) ^ seed);
+                lane1 = Hash_mix_(Hash_read64_(bytes + 16) ^ Hash_secret_[2], Hash_read64_(bytes + 24) ^ lane1);
+                lane2 = Hash_mix_(Hash_read64_(bytes + 32) ^ Hash_secret_[3], Hash_read64_(bytes + 40) ^ lane2);
+                bytes += 48;
+                remaining -= 48;
+            }while(remaining > 48);
+            seed ^= lane1 ^ lane2;
+        }
+        while(remaining > 16){
+            seed = Hash_mix_(Hash_read64_(bytes) ^ Hash_secret_[1], Hash_read64_(bytes + 8) ^ seed);
+            bytes += 16;
+            remaining -= 16;
+        }
+        // last 16 bytes are read whole, overlapping those already consumed if needed
+        a = Hash_read64_(bytes + remaining - 16);
+        b = Hash_read64_(bytes + remaining - 8);
+    }
+    // the seed goes into both operands, so that no input alone decides either of them
+    a ^= Hash_secret_[1] ^ seed;
+    b ^= seed;
+    Hash_multiply_protected_(&a, &b);
+    return Hash_mix_(a ^ Hash_secret_[0] ^ length, b ^ Hash_secret_[1]);
+}
+
+uint64_t Hash_string(const char* string, uint64_t seed){
+    return Hash_bytes(string, strlen(string), seed);
+}
+
+uint64_t Hash_integer(uint64_t value, uint64_t seed){
+    uint64_t a = value ^ seed ^ Hash_secret_[0], b = seed ^ Hash_secret_[1];
+    Hash_multiply_protected_(&a, &b);
+    return Hash_mix_(a ^ Hash_secret_[0], b ^ Hash_secret_[1]);
+}
+
+uint64_t Hash_mix64(uint64_t value){
+    value ^= value >> 30;
+    value *= UINT64_C(0xbf58476d1ce4e5b9);
+    value ^= value >> 27;
+    value *= UINT64_C(0x94d049bb133111eb);
+    value ^= value >> 31;
+    return value;
+}
+
+uint64_t Hash_pointer(const void* pointer){
+    return Hash_mix64((uint64_t)(uintptr_t)pointer);
+}
+
+unsigned int Hash_fold32(uint64_t hash){
+    return (unsigned int)(hash ^ (hash >> 32));
+}
\ No newline at end of file
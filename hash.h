@@ -0,0 +1,32 @@
+#ifndef CxKANOAXDP_hash_H_
+#define CxKANOAXDP_hash_H_
+#include <stddef.h>
+#include <stdint.h>
+// fast, well distributed 64-bit hash functions for use with the hash tables
+//  byte strings are hashed in the manner of wyhash, reading 16 to 48 bytes per step and folding them with
+//   128-bit multiplications. Results depend on byte order, so they shall not be shared across platforms
+//  every function taking a seed gives unrelated results for different seeds. Tables exposed to untrusted
+//   keys should use Hash_seed, so that colliding keys cannot be prepared in advance
+
+// get a seed chosen at random once per process, from the random source of the system where there is one
+uint64_t Hash_seed(void);
+
+// hash a byte string of specified length
+uint64_t Hash_bytes(const void* data, size_t length, uint64_t seed);
+
+// hash a null-terminated string
+uint64_t Hash_string(const char* string, uint64_t seed);
+
+// hash an integer
+uint64_t Hash_integer(uint64_t value, uint64_t seed);
+
+// scramble all bits of an integer, which is a bijection and may serve as an unseeded integer hash
+uint64_t Hash_mix64(uint64_t value);
+
+// hash the address of an object, which suits tables keyed by object identity
+//  the signature matches the 64-bit hash callback of HashTable
+uint64_t Hash_pointer(const void* pointer);
+
+// fold a 64-bit hash into 32 bits, keeping entropy from all bits
+unsigned int Hash_fold32(uint64_t hash);
+#endif
\ No newline at end of file
@@ -1,9 +1,117 @@
 #include "hashtable.h"
+#include "memory.h"
+#include "profile.h"
+#include "reclaimer.h"
 #include "RAII.h"
+#include "standard_fix.h"
+#include <stddef.h>
 #include <stdlib.h>
+enum HashTable_Constant{
+    HashTable_MaxLoadFactor = 1,        // grow once there are more entries than this many per line
+    HashTable_MigrateLines = 1,         // non-empty lines migrated by each operation while growing
+    HashTable_MigrateEmptyVisits = 10,  // empty lines skipped by each operation while growing
+    HashTable_BatchWindow = 16,         // lookups carried out side by side by HashTable_find_batch
+};
+// node of a chain, holding the link, the entry and the full hash of its key in one allocation
+//  the link must be the first member since lines delete nodes through it, and its data points to the entry
+//   so that lines can be walked the same way as any other list
+typedef struct{
+    ListNode link;
+    uint64_t hash;
+    KeyValue entry;
+}HashTableNode_;
 static void HashTable_deleter_(void* target_);
-static inline unsigned int HashTable_bounded_hash_(HashTable* hash_table, void* data){
-    return hash_table->hash(data) % hash_table->lines;
+// keep statements only when built with the stats option
+#if BASE_STATS
+#define HashTable_count_(...) __VA_ARGS__
+#else
+#define HashTable_count_(...)
+#endif
+#if BASE_STATS
+// record a lookup in counters of table
+static inline void HashTable_record_lookup_(HashTable* hash_table, bool hit, size_t probes, size_t compares){
+    HashTableCounters* counters = &hash_table->counters_;
+    counters->lookups += 1;
+    if(hit) counters->hits += 1;
+    else counters->misses += 1;
+    counters->probes += probes;
+    counters->compares += compares;
+    if(probes > counters->max_probes) counters->max_probes = probes;
+}
+#endif
+// get hash of key with whichever hash function the table is initialized with
+static inline uint64_t HashTable_hash_(HashTable* hash_table, void* key){
+    return hash_table->hash64 != NULL ? hash_table->hash64(key) : hash_table->hash(key);
+}
+// get the node holding an entry in table
+static inline HashTableNode_* HashTable_node_(KeyValue* entry){
+    return (HashTableNode_*)((char*)entry - offsetof(HashTableNode_, entry));
+}
+// get the node linked by a list node of a line
+static inline HashTableNode_* HashTable_node_of_link_(ListNode* link){
+    return (HashTableNode_*)link;
+}
+// destroy a node, deallocating key and value if managed, the node itself is freed by RAII_delete
+static void HashTable_node_deleter_(void* target_){
+    RAII_destroy(&HashTable_node_of_link_(target_)->entry);
+}
+// get the line holding entries with specified hash, which may be in either index while growing
+static inline List* HashTable_line_(HashTable* hash_table, uint64_t hash){
+    if(hash_table->previous_index_ != NULL){
+        const size_t previous_line = hash & (hash_table->previous_lines_ - 1);
+        if(previous_line >= hash_table->migrated_lines_) return hash_table->previous_index_ + previous_line;
+    }
+    return hash_table->index + (hash & (hash_table->lines - 1));
+}
+// allocate an index of empty lines
+static List* HashTable_allocate_index_(size_t lines){
+    Profile_allocating_(ProfileKind_HashTable);
+    List* index = Memory_allocate(sizeof(List) * lines);
+    for(size_t i = 0; i < lines; i++){
+        List_initialize(index + i);
+    }
+    return index;
+}
+// migrate entries in a line of previous index to the current one
+//  entries are appended in order so that the latest inserted among same keys stay in front
+static void HashTable_migrate_line_(HashTable* hash_table, List* line){
+    while(!List_empty(line)){
+        ListNode* node = line->head.next;
+        List_detach(line, node);
+        // the hash is kept in node, so keys need not be hashed again
+        const uint64_t hash = HashTable_node_of_link_(node)->hash;
+        List_emplace_back(hash_table->index + (hash & (hash_table->lines - 1)), node);
+    }
+}
+// carry on growing if it is in progress, migrating a few lines, or all lines if complete is set
+static void HashTable_migrate_(HashTable* hash_table, bool complete){
+    if(hash_table->previous_index_ == NULL) return;
+    unsigned int migrated = 0, empty_visits = 0;
+    while(hash_table->migrated_lines_ < hash_table->previous_lines_){
+        List* line = hash_table->previous_index_ + hash_table->migrated_lines_;
+        if(List_empty(line)){
+            if(!complete && ++empty_visits > HashTable_MigrateEmptyVisits) return;
+        }else{
+            if(!complete && ++migrated > HashTable_MigrateLines) return;
+            HashTable_migrate_line_(hash_table, line);
+        }
+        hash_table->migrated_lines_ += 1;
+    }
+    Memory_release(hash_table->previous_index_);
+    hash_table->previous_index_ = NULL;
+    hash_table->previous_lines_ = 0;
+    hash_table->migrated_lines_ = 0;
+}
+// start growing if the table is overloaded
+static void HashTable_grow_(HashTable* hash_table){
+    if(hash_table->size <= hash_table->lines * HashTable_MaxLoadFactor) return;
+    // the previous growth normally completes long before, finish it if not
+    HashTable_migrate_(hash_table, true);
+    hash_table->previous_index_ = hash_table->index;
+    hash_table->previous_lines_ = hash_table->lines;
+    hash_table->migrated_lines_ = 0;
+    hash_table->lines <<= 1;
+    hash_table->index = HashTable_allocate_index_(hash_table->lines);
 }
 void HashTable_initialize(
     HashTable* hash_table,
@@ -11,67 +119,249 @@ void HashTable_initialize(
     unsigned int (*hash)(const void* target_),
     int (*compare)(const void* lhs_, const void* rhs_)
 ){
-    hash_table->index = malloc(sizeof(List) * lines);
-    hash_table->lines = lines;
-    for(size_t i = 0; i < lines; i++){
-        List_initialize(hash_table->index + i);
-    }
+    size_t rounded_lines = 1;
+    while(rounded_lines < lines) rounded_lines <<= 1;
+    hash_table->index = HashTable_allocate_index_(rounded_lines);
+    hash_table->lines = rounded_lines;
     hash_table->size = 0;
     hash_table->hash = hash;
+    hash_table->hash64 = NULL;
     hash_table->compare = compare;
+    hash_table->previous_index_ = NULL;
+    hash_table->previous_lines_ = 0;
+    hash_table->migrated_lines_ = 0;
+    HashTable_count_(HashTable_stats_reset(hash_table);)
     RAII_set_deleter(hash_table, HashTable_deleter_);
 }
+void HashTable_initialize64(
+    HashTable* hash_table,
+    size_t lines,
+    uint64_t (*hash64)(const void* target_),
+    int (*compare)(const void* lhs_, const void* rhs_)
+){
+    HashTable_initialize(hash_table, lines, NULL, compare);
+    hash_table->hash64 = hash64;
+}
+void HashTable_reserve(HashTable* hash_table, size_t count){
+    size_t lines = hash_table->lines;
+    while(count > lines * HashTable_MaxLoadFactor) lines <<= 1;
+    if(lines == hash_table->lines) return;
+    HashTable_migrate_(hash_table, true);
+    hash_table->previous_index_ = hash_table->index;
+    hash_table->previous_lines_ = hash_table->lines;
+    hash_table->migrated_lines_ = 0;
+    hash_table->lines = lines;
+    hash_table->index = HashTable_allocate_index_(lines);
+    HashTable_migrate_(hash_table, true);
+}
 void HashTable_clear(HashTable* hash_table){
     for(size_t i = 0; i < hash_table->lines; i++){
         List_clear(hash_table->index + i);
     }
+    if(hash_table->previous_index_ != NULL){
+        for(size_t i = hash_table->migrated_lines_; i < hash_table->previous_lines_; i++){
+            List_clear(hash_table->previous_index_ + i);
+        }
+        Memory_release(hash_table->previous_index_);
+        hash_table->previous_index_ = NULL;
+        hash_table->previous_lines_ = 0;
+        hash_table->migrated_lines_ = 0;
+    }
     hash_table->size = 0;
 }
-KeyValue* HashTable_find(HashTable* hash_table, void* key){
-    unsigned int hash = HashTable_bounded_hash_(hash_table, key);
-    List* target_link = &hash_table->index[hash];
-    for(ListNode* target = target_link->head.next; target != &target_link->head; target = target->next){
-        KeyValue* current = (KeyValue*)(target->data);
-        if(hash_table->compare(key, current->key) == 0) return current;
-    }
-    return NULL;
-}
-void HashTable_erase_entry_key_hint(HashTable* hash_table, void* hint, KeyValue* entry){
-    unsigned int hash = HashTable_bounded_hash_(hash_table, hint);
-    List* target_link = &hash_table->index[hash];
-    for(ListNode* target = target_link->head.next; target != &target_link->head; target = target->next){
-        KeyValue* current = (KeyValue*)(target->data);
-        if(current == entry){
-            List_erase(target_link, target);
+void HashTable_clear_deferred(HashTable* hash_table){
+    if(hash_table->size == 0) return;
+    // indexes move to a table of its own, whose deleter clears lines and releases indexes but not itself
+    Profile_allocating_(ProfileKind_HashTable);
+    HashTable* detached = (HashTable*)Memory_allocate_object(sizeof(HashTable));
+    *detached = *hash_table;
+    hash_table->index = HashTable_allocate_index_(1);
+    hash_table->lines = 1;
+    hash_table->size = 0;
+    hash_table->previous_index_ = NULL;
+    hash_table->previous_lines_ = 0;
+    hash_table->migrated_lines_ = 0;
+    Reclaimer_defer(detached);
+}
+// lookup entry starting from specified node of a line, comparing keys only when hashes match
+static inline KeyValue* HashTable_find_from_(
+    HashTable* hash_table, List* line, ListNode* first, void* key, uint64_t hash
+){
+    KeyValue* result = NULL;
+    HashTable_count_(size_t probes = 0, compares = 0;)
+    for(ListNode* target = first; target != &line->head; target = target->next){
+        HashTableNode_* current = HashTable_node_of_link_(target);
+        HashTable_count_(probes += 1;)
+        if(current->hash != hash) continue;
+        HashTable_count_(compares += 1;)
+        if(hash_table->compare(key, current->entry.key) == 0){
+            result = &current->entry;
             break;
         }
     }
+    HashTable_count_(HashTable_record_lookup_(hash_table, result != NULL, probes, compares);)
+    return result;
+}
+// insert a new entry with key of specified hash, ignoring any key conflict
+static KeyValue* HashTable_insert_hashed_(
+    HashTable* hash_table, uint64_t hash, void* key, bool owns_key, void* value, bool owns_value
+){
+    Profile_allocating_(ProfileKind_HashTable);
+    HashTableNode_* node = (HashTableNode_*)Memory_allocate_object(sizeof(HashTableNode_));
+    KeyValue_initialize(&node->entry, key, owns_key, value, owns_value);
+    node->hash = hash;
+    node->link.data = &node->entry;
+    RAII_set_deleter(&node->link, HashTable_node_deleter_);
+    List_emplace_front(HashTable_line_(hash_table, hash), &node->link);
+    hash_table->size += 1;
+    HashTable_grow_(hash_table);
+    return &node->entry;
+}
+KeyValue* HashTable_find(HashTable* hash_table, void* key){
+    Profile_operation_(ProfileKind_HashTable);
+    HashTable_migrate_(hash_table, false);
+    const uint64_t hash = HashTable_hash_(hash_table, key);
+    List* line = HashTable_line_(hash_table, hash);
+    return HashTable_find_from_(hash_table, line, line->head.next, key, hash);
+}
+void HashTable_find_batch(HashTable* hash_table, void** keys, size_t count, KeyValue** results){
+    Profile_operation_(ProfileKind_HashTable);
+    uint64_t hashes[HashTable_BatchWindow];
+    List* lines[HashTable_BatchWindow];
+    ListNode* nodes[HashTable_BatchWindow];
+    for(size_t first = 0; first < count; first += HashTable_BatchWindow){
+        const size_t window = count - first < HashTable_BatchWindow ? count - first : HashTable_BatchWindow;
+        void** window_keys = keys + first;
+        KeyValue** window_results = results + first;
+        HashTable_migrate_(hash_table, false);
+        // each stage issues loads for all lookups before any of them is waited for in the next stage
+        for(size_t i = 0; i < window; i++){
+            hashes[i] = HashTable_hash_(hash_table, window_keys[i]);
+            lines[i] = HashTable_line_(hash_table, hashes[i]);
+            Prefetch(&lines[i]->head.next);
+        }
+        for(size_t i = 0; i < window; i++){
+            nodes[i] = lines[i]->head.next;
+            Prefetch(nodes[i]);
+        }
+        // keys are only needed when the hash matches, which it rarely does otherwise
+        for(size_t i = 0; i < window; i++){
+            if(nodes[i] != &lines[i]->head && HashTable_node_of_link_(nodes[i])->hash == hashes[i]){
+                Prefetch(HashTable_node_of_link_(nodes[i])->entry.key);
+            }
+        }
+        for(size_t i = 0; i < window; i++){
+            window_results[i] = HashTable_find_from_(hash_table, lines[i], nodes[i], window_keys[i], hashes[i]);
+        }
+    }
+}
+void HashTable_erase_entry(HashTable* hash_table, KeyValue* entry){
+    Profile_operation_(ProfileKind_HashTable);
+    HashTable_migrate_(hash_table, false);
+    HashTableNode_* node = HashTable_node_(entry);
+    List_erase(HashTable_line_(hash_table, node->hash), &node->link);
+    hash_table->size -= 1;
+}
+void HashTable_erase_entry_key_hint(HashTable* hash_table, Unused void* hint, KeyValue* entry){
+    HashTable_erase_entry(hash_table, entry);
 }
 KeyValue* HashTable_insert_direct(
     HashTable* hash_table, void* key, bool owns_key, void* value, bool owns_value
 ){
-    unsigned int hash = HashTable_bounded_hash_(hash_table, key);
-    KeyValue* entry = KeyValue_create(key, owns_key, value, owns_value);
-    ListNode* node = ListNode_create(entry, true);
-    List_emplace_front(&hash_table->index[hash], node);
-    return entry;
+    Profile_operation_(ProfileKind_HashTable);
+    HashTable_migrate_(hash_table, false);
+    return HashTable_insert_hashed_(hash_table, HashTable_hash_(hash_table, key), key, owns_key, value, owns_value);
 }
 bool HashTable_insert(
     HashTable* hash_table, void* key, bool owns_key, void* value, bool owns_value,
     KeyValue** result
 ){
-    KeyValue* find_result = HashTable_find(hash_table, key);
+    Profile_operation_(ProfileKind_HashTable);
+    HashTable_migrate_(hash_table, false);
+    const uint64_t hash = HashTable_hash_(hash_table, key);
+    List* line = HashTable_line_(hash_table, hash);
+    KeyValue* find_result = HashTable_find_from_(hash_table, line, line->head.next, key, hash);
     if(find_result != NULL){
         if(result != NULL) *result = find_result;
         return false;
     }
-    find_result = HashTable_insert_direct(hash_table, key, owns_key, value, owns_value);
+    find_result = HashTable_insert_hashed_(hash_table, hash, key, owns_key, value, owns_value);
     if(result != NULL) *result = find_result;
     return true;
 }
 static void HashTable_deleter_(void* target_){
     HashTable* target = target_;
     HashTable_clear(target);
-    free(target->index);
-    free(target);
+    Memory_release(target->index);
+}
+// visit entries in lines of an index
+static void HashTable_foreach_lines_(
+    List* index, size_t first, size_t last, void (*visit)(KeyValue* entry, void* context), void* context
+){
+    for(size_t i = first; i < last; i++){
+        for(ListNode* target = index[i].head.next; target != &index[i].head; target = target->next){
+            visit(&HashTable_node_of_link_(target)->entry, context);
+        }
+    }
+}
+void HashTable_foreach(HashTable* hash_table, void (*visit)(KeyValue* entry, void* context), void* context){
+    HashTable_foreach_lines_(hash_table->index, 0, hash_table->lines, visit, context);
+    if(hash_table->previous_index_ != NULL){
+        HashTable_foreach_lines_(
+            hash_table->previous_index_, hash_table->migrated_lines_, hash_table->previous_lines_, visit, context
+        );
+    }
+}
+// add lengths of chains in lines of an index to statistics
+static void HashTable_stats_lines_(HashTableStats* stats, List* index, size_t first, size_t last){
+    for(size_t i = first; i < last; i++){
+        const size_t length = index[i].size;
+        stats->chain_lengths[length < HashTableStats_Bins ? length : HashTableStats_Bins - 1] += 1;
+        if(length > stats->max_chain_length) stats->max_chain_length = length;
+    }
+}
+void HashTable_stats(HashTable* hash_table, HashTableStats* stats){
+    *stats = (HashTableStats){
+        .size = hash_table->size,
+        .lines = hash_table->lines,
+        .load_factor = (double)hash_table->size / hash_table->lines,
+    };
+    HashTable_stats_lines_(stats, hash_table->index, 0, hash_table->lines);
+    // lines not migrated yet still hold their entries while growing
+    if(hash_table->previous_index_ != NULL){
+        HashTable_stats_lines_(
+            stats, hash_table->previous_index_, hash_table->migrated_lines_, hash_table->previous_lines_
+        );
+    }
+    HashTable_count_(stats->counters = hash_table->counters_;)
+}
+void HashTable_stats_reset(Unused HashTable* hash_table){
+    HashTable_count_(hash_table->counters_ = (HashTableCounters){0};)
+}
+void HashTable_stats_dump(HashTable* hash_table, FILE* stream){
+    HashTableStats stats;
+    HashTable_stats(hash_table, &stats);
+    fprintf(
+        stream, "[HashTable]: size %zu, lines %zu, load factor %.3f, longest chain %zu\n",
+        stats.size, stats.lines, stats.load_factor, stats.max_chain_length
+    );
+    fprintf(stream, "[HashTable]: chain lengths");
+    for(unsigned int i = 0; i < HashTableStats_Bins; i++){
+        if(stats.chain_lengths[i] == 0) continue;
+        fprintf(stream, " %u%s: %zu", i, i == HashTableStats_Bins - 1 ? "+" : "", stats.chain_lengths[i]);
+    }
+    fprintf(stream, "\n");
+    #if BASE_STATS
+    const HashTableCounters* counters = &stats.counters;
+    const double lookups = counters->lookups == 0 ? 1 : (double)counters->lookups;
+    fprintf(
+        stream, "[HashTable]: lookups %zu, hits %zu (%.1f%%), misses %zu (%.1f%%)\n",
+        counters->lookups, counters->hits, counters->hits * 100 / lookups,
+        counters->misses, counters->misses * 100 / lookups
+    );
+    fprintf(
+        stream, "[HashTable]: probes %.3f per lookup (max %zu), compares %.3f per lookup\n",
+        counters->probes / lookups, counters->max_probes, counters->compares / lookups
+    );
+    #endif
 }
\ No newline at end of file
@@ -1,19 +1,65 @@
 #ifndef CxKANOAXDP_Hashtable_H_
 #define CxKANOAXDP_Hashtable_H_
 #include "RAII.h"
+#include "baSe_config.h"
 #include "keyvalue_pair.h"
 #include "list.h"
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+enum HashTableStats_Constant{
+    HashTableStats_Bins = 16,   // bins of chain length histogram, the last one counts all longer chains too
+};
+// counters of lookups on a hash table, maintained only when built with the stats option
+//  every lookup counts, including the one HashTable_insert makes for an existing key
+typedef struct{
+    size_t lookups;
+    size_t hits;
+    size_t misses;
+    // nodes visited and keys compared over all lookups
+    size_t probes;
+    size_t compares;
+    // most nodes visited by a single lookup
+    size_t max_probes;
+}HashTableCounters;
+// hash table with separate chaining, which grows by doubling the number of lines as entries are inserted
+//  growing is done incrementally: lines of the previous index are migrated a few at a time by later
+//  operations on the table, so no single operation pays for moving all entries
+//  each entry is allocated along with its list node and the full hash of its key, keys are compared only
+//   when hashes match. The data of list nodes in lines are the entries
 typedef struct{
     RAII _;
     List* index;
     size_t size;
     size_t lines;
     unsigned int (*hash)(const void* key);
+    // 64-bit hash used instead of hash if not NULL
+    uint64_t (*hash64)(const void* key);
     int (*compare)(const void* lhs_, const void* rhs_);
+    // index being migrated to the current one, NULL if not growing
+    List* previous_index_;
+    size_t previous_lines_;
+    // number of lines in previous index that have been migrated
+    size_t migrated_lines_;
+    #if BASE_STATS
+    HashTableCounters counters_;
+    #endif
 }HashTable;
 
+// statistics of a hash table, as gathered by HashTable_stats
+typedef struct{
+    size_t size;
+    size_t lines;
+    double load_factor;
+    // number of lines holding each number of entries
+    size_t chain_lengths[HashTableStats_Bins];
+    size_t max_chain_length;
+    // all zero unless built with the stats option
+    HashTableCounters counters;
+}HashTableStats;
+
 // initialize hashtable
+//  lines is rounded up to a power of 2
 void HashTable_initialize(
     HashTable* hash_table,
     size_t lines,
@@ -21,19 +67,48 @@ void HashTable_initialize(
     int (*compare)(const void* lhs_, const void* rhs_)
 );
 
+// initialize hashtable with a 64-bit hash, such as those provided by hash.h
+//  lines is rounded up to a power of 2. Unlike a 32-bit hash, the hash keeps distinguishing lines once
+//   there are more than 2^32 of them
+void HashTable_initialize64(
+    HashTable* hash_table,
+    size_t lines,
+    uint64_t (*hash64)(const void* target_),
+    int (*compare)(const void* lhs_, const void* rhs_)
+);
+
 // clear up hash table
 void HashTable_clear(HashTable* hash_table);
 
+// make room for count entries in total, so that the table does not grow until there are more
+//  all lines are allocated at once and existing entries moved to them, including those still to be migrated
+void HashTable_reserve(HashTable* hash_table, size_t count);
+
+// clear up hash table in constant time, handing entries over to the reclaimer thread to be deleted
+//  the table starts over with a single line, growing again as entries are inserted
+void HashTable_clear_deferred(HashTable* hash_table);
+
 // lookup entry within hashtable
 //  if multiple entries with same key exists, the last one inserted will be returned
 KeyValue* HashTable_find(HashTable* hash_table, void* key);
 
+// lookup entries of multiple keys at once, storing the entry found for each key into results, or NULL
+//  same as calling HashTable_find on each key in turn, but lookups are carried out side by side in stages,
+//   prefetching lines, then nodes, then entries and keys of all of them, so that cache misses of
+//   different lookups overlap rather than follow one another
+void HashTable_find_batch(HashTable* hash_table, void** keys, size_t count, KeyValue** results);
+
 // insert a new entry to hashtable, ignore any key conflict that may happen
 KeyValue* HashTable_insert_direct(
     HashTable* hash_table, void* key, bool owns_key, void* value, bool owns_value
 );
 
+// remove an entry from hashtable, which takes constant time
+//  the entry must be one returned by the table and not removed yet
+void HashTable_erase_entry(HashTable* hash_table, KeyValue* entry);
+
 // remove a entry from hashtable with key hint
+//  the hint is no longer needed since entries know where they are, same as HashTable_erase_entry
 void HashTable_erase_entry_key_hint(HashTable* hash_table, void* hint, KeyValue* entry);
 
 // insert a new entry to hashtable
@@ -41,4 +116,17 @@ bool HashTable_insert(
     HashTable* hash_table, void* key, bool owns_key, void* value, bool owns_value,
     KeyValue** result
 );
+
+// call visit on every entry in hashtable along with context
+//  entries with same key are visited from the last inserted on. The table must not be modified meanwhile
+void HashTable_foreach(HashTable* hash_table, void (*visit)(KeyValue* entry, void* context), void* context);
+
+// gather statistics of hashtable, which walks all lines
+void HashTable_stats(HashTable* hash_table, HashTableStats* stats);
+
+// reset counters of lookups on hashtable
+void HashTable_stats_reset(HashTable* hash_table);
+
+// print statistics of hashtable in human readable form
+void HashTable_stats_dump(HashTable* hash_table, FILE* stream);
 #endif
\ No newline at end of file
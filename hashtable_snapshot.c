@@ -0,0 +1,281 @@
+#include "hashtable_snapshot.h"
+#include "RAII.h"
+#include "hash.h"
+#include "memory.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__unix__) || defined(__APPLE__)
+#define HashTableSnapshot_Mmap_ 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define HashTableSnapshot_Mmap_ 0
+#endif
+// [DESIGN: Snapshot File Format]
+//  a snapshot file consists of four consecutive parts, with all integers 64 bits wide:
+//   1. The header, holding the signature baSeHTS followed by a byte of format version, the seed keys are
+//    hashed with, number of entries, number of buckets which is a power of 2, and length of the blob area
+//   2. The bucket table of buckets + 1 integers. Entries of bucket i are those from the bucket table's
+//    element i up to element i + 1 exclusively, so the first element is 0 and the last is number of entries
+//   3. The entry table, each entry holding full hash of its key, and offset and length of its key and value
+//    within the blob area. Entries are grouped by bucket, which is selected by lower bits of hash
+//   4. The blob area, holding bytes of keys and values, entry after entry
+//  lookups hash the key with Hash_bytes, then scan entries of its bucket comparing hashes first. Since
+//   there are no fewer buckets than entries, a bucket holds one entry on average
+//  nothing is validated beyond the header when opening, references read from the file are checked against
+//   its size when they are followed instead, so that opening takes constant time yet a corrupted file
+//   cannot lead lookups out of the mapped area
+enum HashTableSnapshot_Constant{
+    HashTableSnapshot_Version = 1,  // version of file format, bumped on incompatible changes
+};
+static const char HashTableSnapshot_signature_[8] = {'b', 'a', 'S', 'e', 'H', 'T', 'S', HashTableSnapshot_Version};
+typedef struct{
+    char signature[8];
+    uint64_t seed;
+    uint64_t count;
+    uint64_t buckets;
+    uint64_t blobs_length;
+}HashTableSnapshotHeader_;
+typedef struct{
+    uint64_t hash;
+    uint64_t key_offset;
+    uint64_t key_length;
+    uint64_t value_offset;
+    uint64_t value_length;
+}HashTableSnapshotEntry_;
+struct HashTableSnapshot{
+    RAII _;
+    unsigned char* data_;
+    size_t length_;
+    HashTableSnapshotHeader_ header_;
+    const uint64_t* buckets_;
+    const HashTableSnapshotEntry_* entries_;
+    const unsigned char* blobs_;
+};
+// entry gathered from a hash table while writing
+typedef struct{
+    uint64_t hash;
+    const void* key;
+    size_t key_length;
+    const void* value;
+    size_t value_length;
+}HashTableSnapshotRecord_;
+typedef struct{
+    HashTableSnapshotRecord_* records;
+    size_t count;
+    uint64_t seed;
+    HashTableSnapshot_Serializer key_bytes;
+    HashTableSnapshot_Serializer value_bytes;
+}HashTableSnapshotWriter_;
+
+// turn an entry of hash table into a record
+static void HashTableSnapshot_gather_(KeyValue* entry, void* context){
+    HashTableSnapshotWriter_* writer = (HashTableSnapshotWriter_*)context;
+    HashTableSnapshotRecord_* record = writer->records + writer->count++;
+    record->key_length = writer->key_bytes(entry->key, &record->key);
+    record->hash = Hash_bytes(record->key, record->key_length, writer->seed);
+    if(writer->value_bytes != NULL){
+        record->value_length = writer->value_bytes(entry->value, &record->value);
+    }else{
+        record->value = NULL;
+        record->value_length = 0;
+    }
+}
+
+// write all parts of snapshot to stream, records are given in bucket order
+//  return if all writes succeed
+static bool HashTableSnapshot_write_stream_(
+    FILE* stream, const HashTableSnapshotHeader_* header, const uint64_t* buckets,
+    const HashTableSnapshotRecord_* records
+){
+    bool success = fwrite(header, sizeof(*header), 1, stream) == 1;
+    success = success && fwrite(buckets, sizeof(uint64_t), header->buckets + 1, stream) == header->buckets + 1;
+    uint64_t offset = 0;
+    for(uint64_t i = 0; success && i < header->count; i++){
+        const HashTableSnapshotEntry_ entry = {
+            .hash = records[i].hash,
+            .key_offset = offset,
+            .key_length = records[i].key_length,
+            .value_offset = offset + records[i].key_length,
+            .value_length = records[i].value_length,
+        };
+        offset += records[i].key_length + records[i].value_length;
+        success = fwrite(&entry, sizeof(entry), 1, stream) == 1;
+    }
+    for(uint64_t i = 0; success && i < header->count; i++){
+        success = fwrite(records[i].key, 1, records[i].key_length, stream) == records[i].key_length
+                  && fwrite(records[i].value, 1, records[i].value_length, stream) == records[i].value_length;
+    }
+    return success;
+}
+
+// release memory holding the file
+static void HashTableSnapshot_destroy_(HashTableSnapshot* snapshot){
+    #if HashTableSnapshot_Mmap_
+    munmap(snapshot->data_, snapshot->length_);
+    #else
+    free(snapshot->data_);
+    #endif
+}
+
+// bring the whole file at path into memory
+//  return if succeeded, in which case data and length receive the memory holding the file
+static bool HashTableSnapshot_load_(const char* path, unsigned char** data, size_t* length){
+    #if HashTableSnapshot_Mmap_
+    const int descriptor = open(path, O_RDONLY);
+    if(descriptor < 0) return false;
+    struct stat status;
+    bool success = fstat(descriptor, &status) == 0 && status.st_size > 0;
+    if(success){
+        *length = (size_t)status.st_size;
+        *data = mmap(NULL, *length, PROT_READ, MAP_SHARED, descriptor, 0);
+        success = *data != MAP_FAILED;
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(descriptor);
+    return success;
+    #else
+    FILE* stream = fopen(path, "rb");
+    if(stream == NULL) return false;
+    bool success = fseek(stream, 0, SEEK_END) == 0;
+    const long end = success ? ftell(stream) : -1;
+    success = end > 0 && fseek(stream, 0, SEEK_SET) == 0;
+    if(success){
+        *length = (size_t)end;
+        *data = (unsigned char*)malloc(*length);
+        success = fread(*data, 1, *length, stream) == *length;
+        if(!success) free(*data);
+    }
+    fclose(stream);
+    return success;
+    #endif
+}
+
+bool HashTableSnapshot_write(
+    HashTable* hash_table,
+    const char* path,
+    HashTableSnapshot_Serializer key_bytes,
+    HashTableSnapshot_Serializer value_bytes
+){
+    HashTableSnapshotWriter_ writer = {
+        .records = (HashTableSnapshotRecord_*)malloc(sizeof(HashTableSnapshotRecord_) * (hash_table->size + 1)),
+        .count = 0,
+        .seed = Hash_seed(),
+        .key_bytes = key_bytes,
+        .value_bytes = value_bytes,
+    };
+    HashTable_foreach(hash_table, HashTableSnapshot_gather_, &writer);
+    HashTableSnapshotHeader_ header = {.seed = writer.seed, .count = writer.count, .buckets = 1};
+    memcpy(header.signature, HashTableSnapshot_signature_, sizeof(header.signature));
+    while(header.buckets < header.count) header.buckets <<= 1;
+    // arrange records by bucket, keeping their order within each bucket so that the entry found first
+    //  among same keys stays the same
+    uint64_t* buckets = (uint64_t*)calloc(header.buckets + 1, sizeof(uint64_t));
+    HashTableSnapshotRecord_* arranged = (HashTableSnapshotRecord_*)malloc(
+        sizeof(HashTableSnapshotRecord_) * (header.count + 1)
+    );
+    for(size_t i = 0; i < writer.count; i++){
+        buckets[(writer.records[i].hash & (header.buckets - 1)) + 1] += 1;
+        header.blobs_length += writer.records[i].key_length + writer.records[i].value_length;
+    }
+    for(uint64_t i = 0; i < header.buckets; i++) buckets[i + 1] += buckets[i];
+    for(size_t i = 0; i < writer.count; i++){
+        arranged[buckets[writer.records[i].hash & (header.buckets - 1)]++] = writer.records[i];
+    }
+    // placing shifted each bucket start to where the next bucket starts
+    memmove(buckets + 1, buckets, sizeof(uint64_t) * header.buckets);
+    buckets[0] = 0;
+    // write to a temporary file first, so that readers of an existing snapshot never see a partial one
+    const size_t path_length = strlen(path);
+    char* temporary_path = (char*)malloc(path_length + 5);
+    memcpy(temporary_path, path, path_length);
+    memcpy(temporary_path + path_length, ".tmp", 5);
+    FILE* stream = fopen(temporary_path, "wb");
+    bool success = stream != NULL;
+    if(success){
+        success = HashTableSnapshot_write_stream_(stream, &header, buckets, arranged);
+        success = fclose(stream) == 0 && success;
+        success = success && rename(temporary_path, path) == 0;
+        if(!success) remove(temporary_path);
+    }
+    #ifndef NDEBUG
+    if(!success) fprintf(stderr, "[HashTableSnapshot]: Failed to write snapshot to %s\n", path);
+    #endif
+    free(temporary_path);
+    free(arranged);
+    free(buckets);
+    free(writer.records);
+    return success;
+}
+
+HashTableSnapshot* HashTableSnapshot_open(const char* path){
+    unsigned char* data;
+    size_t length;
+    if(!HashTableSnapshot_load_(path, &data, &length)){
+        #ifndef NDEBUG
+        fprintf(stderr, "[HashTableSnapshot]: Failed to load snapshot from %s\n", path);
+        #endif
+        return NULL;
+    }
+    HashTableSnapshot* snapshot = (HashTableSnapshot*)Memory_allocate_object(sizeof(HashTableSnapshot));
+    snapshot->data_ = data;
+    snapshot->length_ = length;
+    RAII_set_deleter(snapshot, (void(*)(void*))HashTableSnapshot_destroy_);
+    // sizes of all parts must add up to the size of file, checked without overflowing
+    bool valid = length >= sizeof(HashTableSnapshotHeader_);
+    if(valid){
+        memcpy(&snapshot->header_, data, sizeof(HashTableSnapshotHeader_));
+        const HashTableSnapshotHeader_* header = &snapshot->header_;
+        uint64_t rest = length - sizeof(HashTableSnapshotHeader_);
+        valid = memcmp(header->signature, HashTableSnapshot_signature_, sizeof(header->signature)) == 0
+                && header->buckets != 0 && (header->buckets & (header->buckets - 1)) == 0
+                && header->buckets < rest / sizeof(uint64_t);
+        if(valid){
+            rest -= (header->buckets + 1) * sizeof(uint64_t);
+            valid = header->count <= rest / sizeof(HashTableSnapshotEntry_)
+                    && header->blobs_length == rest - header->count * sizeof(HashTableSnapshotEntry_);
+        }
+    }
+    if(!valid){
+        #ifndef NDEBUG
+        fprintf(stderr, "[HashTableSnapshot]: Corrupted snapshot %s\n", path);
+        #endif
+        RAII_delete(snapshot);
+        return NULL;
+    }
+    snapshot->buckets_ = (const uint64_t*)(data + sizeof(HashTableSnapshotHeader_));
+    snapshot->entries_ = (const HashTableSnapshotEntry_*)(snapshot->buckets_ + snapshot->header_.buckets + 1);
+    snapshot->blobs_ = (const unsigned char*)(snapshot->entries_ + snapshot->header_.count);
+    return snapshot;
+}
+
+size_t HashTableSnapshot_size(HashTableSnapshot* snapshot){
+    return snapshot->header_.count;
+}
+
+const void* HashTableSnapshot_find(
+    HashTableSnapshot* snapshot, const void* key, size_t key_length, size_t* value_length
+){
+    const HashTableSnapshotHeader_* header = &snapshot->header_;
+    const uint64_t hash = Hash_bytes(key, key_length, header->seed);
+    const uint64_t bucket = hash & (header->buckets - 1);
+    const uint64_t first = snapshot->buckets_[bucket];
+    const uint64_t last = snapshot->buckets_[bucket + 1];
+    if(first > last || last > header->count) return NULL;
+    for(uint64_t i = first; i < last; i++){
+        const HashTableSnapshotEntry_* entry = snapshot->entries_ + i;
+        if(entry->hash != hash || entry->key_length != key_length) continue;
+        if(entry->key_offset > header->blobs_length
+           || key_length > header->blobs_length - entry->key_offset) continue;
+        if(memcmp(snapshot->blobs_ + entry->key_offset, key, key_length) != 0) continue;
+        if(entry->value_offset > header->blobs_length
+           || entry->value_length > header->blobs_length - entry->value_offset) return NULL;
+        if(value_length != NULL) *value_length = entry->value_length;
+        return snapshot->blobs_ + entry->value_offset;
+    }
+    return NULL;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef CxKANOAXDP_hashtable_snapshot_H_
+#define CxKANOAXDP_hashtable_snapshot_H_
+#include "hashtable.h"
+#include <stdbool.h>
+#include <stddef.h>
+// read-only image of a hash table stored in a file, which is mapped into memory and queried in place
+//  keys and values are stored as byte strings, and all references within the file are offsets, so opening
+//   a snapshot takes constant time regardless of its size and no entry is ever decoded or copied
+//  the file is laid out in byte order of the machine writing it and may only be read on machines alike
+typedef struct HashTableSnapshot HashTableSnapshot;
+
+// get the bytes representing a key or value stored in a hash table
+//  bytes receives the start of bytes, which shall stay valid until the snapshot is written
+//  return number of bytes
+typedef size_t (*HashTableSnapshot_Serializer)(const void* object, const void** bytes);
+
+// write entries in hash table to a snapshot file at path, replacing it if already exists
+//  value_bytes may be NULL, in which case all values are stored as empty
+//  return if the snapshot is written successfully
+bool HashTableSnapshot_write(
+    HashTable* hash_table,
+    const char* path,
+    HashTableSnapshot_Serializer key_bytes,
+    HashTableSnapshot_Serializer value_bytes
+);
+
+// open a snapshot file at path for lookups
+//  return NULL if the file cannot be opened or is not a valid snapshot
+HashTableSnapshot* HashTableSnapshot_open(const char* path);
+
+// get number of entries in snapshot
+size_t HashTableSnapshot_size(HashTableSnapshot* snapshot);
+
+// lookup value with key of specified bytes within snapshot
+//  if multiple entries with same key exists, the one HashTable_find returned when writing is found
+//  value_length receives number of bytes of value if not NULL
+//  return the bytes of value, which stay valid until the snapshot is deleted, or NULL if not found
+const void* HashTableSnapshot_find(
+    HashTableSnapshot* snapshot, const void* key, size_t key_length, size_t* value_length
+);
+#endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "heap.h"
 #include "keyvalue_pair.h"
+#include "memory.h"
+#include "profile.h"
 #include "vector.h"
 struct Heap{
     RAII _;
@@ -7,28 +9,46 @@ struct Heap{
     int (*compare_)(const void* lhs_, const void* rhs_);
 };
 
-// adjust the last element in heap upwards
-static void Heap_swim_(Heap* heap){
-    if(Vector_size(heap->data_) <= 1) return;
-    unsigned int current_index = Vector_size(heap->data_) - 1;
-    KeyValue* item = (KeyValue*)Vector_at(heap->data_, current_index);
+// element stored in heap, which records its own position so that it can be located from its entry
+//  the entry must be the first member since handles given out are pointers to it
+typedef struct{
+    KeyValue entry;
+    unsigned int position;
+}HeapNode_;
+
+// get the element at specified position in heap
+static inline HeapNode_* Heap_at_(Heap* heap, unsigned int index){
+    return (HeapNode_*)Vector_at(heap->data_, index);
+}
+
+// swap two elements in heap, keeping their recorded positions up to date
+static inline void Heap_swap_(Heap* heap, unsigned int p, unsigned int q){
+    Vector_swap(heap->data_, p, q);
+    Heap_at_(heap, p)->position = p;
+    Heap_at_(heap, q)->position = q;
+}
+
+// adjust the element at specified position in heap upwards
+//  return the position where the element finally settles
+static unsigned int Heap_swim_(Heap* heap, unsigned int current_index){
+    KeyValue* item = &Heap_at_(heap, current_index)->entry;
     while(current_index != 0){
         unsigned int parent_index = ((current_index + 1) >> 1) - 1;
-        KeyValue* parent_item = (KeyValue*)Vector_at(heap->data_, parent_index);
+        KeyValue* parent_item = &Heap_at_(heap, parent_index)->entry;
         if(heap->compare_(item->key, parent_item->key) < 0){
-            Vector_swap(heap->data_, parent_index, current_index);
+            Heap_swap_(heap, parent_index, current_index);
             current_index = parent_index;
         }else{
             break;
         }
     }
+    return current_index;
 }
 
-// adjust the first element in heap downwards
-static void Heap_sink_(Heap* heap){
-    if(Vector_size(heap->data_) <= 1) return;
-    unsigned int current_index = 0;
-    KeyValue* item = (KeyValue*)Vector_at(heap->data_, current_index);
+// adjust the element at specified position in heap downwards
+//  return the position where the element finally settles
+static unsigned int Heap_sink_(Heap* heap, unsigned int current_index){
+    KeyValue* item = &Heap_at_(heap, current_index)->entry;
     while(((current_index + 1) << 1) - 1 < Vector_size(heap->data_)){
         unsigned int right_child_index = (current_index + 1) << 1;
         unsigned int left_child_index = right_child_index - 1;
@@ -36,10 +56,10 @@ static void Heap_sink_(Heap* heap){
         KeyValue* compare_target_item = NULL;
         if(right_child_index >= Vector_size(heap->data_)){
             compare_target_index = left_child_index;
-            compare_target_item = (KeyValue*)Vector_at(heap->data_, left_child_index);
+            compare_target_item = &Heap_at_(heap, left_child_index)->entry;
         }else{
-            KeyValue* left_child_item = (KeyValue*)Vector_at(heap->data_, left_child_index);
-            KeyValue* right_child_item = (KeyValue*)Vector_at(heap->data_, right_child_index);
+            KeyValue* left_child_item = &Heap_at_(heap, left_child_index)->entry;
+            KeyValue* right_child_item = &Heap_at_(heap, right_child_index)->entry;
             if(heap->compare_(left_child_item->key, right_child_item->key) < 0){
                 compare_target_index = left_child_index;
                 compare_target_item = left_child_item;
@@ -49,12 +69,41 @@ static void Heap_sink_(Heap* heap){
             }
         }
         if(heap->compare_(item->key, compare_target_item->key) > 0){
-            Vector_swap(heap->data_, compare_target_index, current_index);
+            Heap_swap_(heap, compare_target_index, current_index);
             current_index = compare_target_index;
         }else{
             break;
         }
     }
+    return current_index;
+}
+
+// restore the order of heap after elements from specified position onwards are appended without adjusting
+//  either sift the appended elements up one by one or rebuild the whole heap bottom-up, whichever is cheaper
+static void Heap_restore_(Heap* heap, unsigned int first){
+    const unsigned int size = Vector_size(heap->data_);
+    unsigned int depth = 0;
+    for(unsigned int i = size; i > 1; i >>= 1) depth += 1;
+    if((unsigned long long)(size - first) * depth < size){
+        for(unsigned int i = first; i < size; i++) Heap_swim_(heap, i);
+    }else{
+        for(unsigned int i = size >> 1; i > 0; i--) Heap_sink_(heap, i - 1);
+    }
+}
+
+// create an element of heap without placing it
+static HeapNode_* Heap_node_create_(void* key, bool owns_key, void* value, bool owns_value){
+    Profile_allocating_(ProfileKind_Heap);
+    HeapNode_* item = (HeapNode_*)Memory_allocate_object(sizeof(HeapNode_));
+    KeyValue_initialize(&item->entry, key, owns_key, value, owns_value);
+    return item;
+}
+
+// replace key of an entry, deallocating the old one if managed and not reused
+static void Heap_replace_key_(KeyValue* entry, void* key, bool owns_key){
+    if(entry->key_owned && entry->key != key) RAII_delete(entry->key);
+    entry->key = key;
+    entry->key_owned = owns_key;
 }
 
 // destroy the heap
@@ -64,7 +113,8 @@ static void Heap_destroy_(Heap* heap){
 
 // initialize a heap
 Heap* Heap_create(int (*compare)(const void* lhs_, const void* rhs_)){
-    Heap* heap = (Heap*)malloc(sizeof(Heap));
+    Profile_allocating_(ProfileKind_Heap);
+    Heap* heap = (Heap*)Memory_allocate_object(sizeof(Heap));
     heap->data_ = Vector_create();
     heap->compare_ = compare;
     RAII_set_deleter(heap, (void(*)(void*))Heap_destroy_);
@@ -79,20 +129,93 @@ unsigned int Heap_size(Heap* heap){
     return Vector_size(heap->data_);
 }
 
-void Heap_insert(Heap* heap, void* key, bool owns_key, void* value, bool owns_value){
-    KeyValue* item = (KeyValue*)KeyValue_create(key, owns_key, value, owns_value);
+KeyValue* Heap_insert(Heap* heap, void* key, bool owns_key, void* value, bool owns_value){
+    Profile_operation_(ProfileKind_Heap);
+    HeapNode_* item = Heap_node_create_(key, owns_key, value, owns_value);
+    item->position = Vector_size(heap->data_);
     Vector_emplace_back(heap->data_, item, true);
-    Heap_swim_(heap);
+    Heap_swim_(heap, item->position);
+    return &item->entry;
+}
+
+void Heap_build(Heap* heap, void** keys, bool owns_keys, void** values, bool owns_values, unsigned int count){
+    const unsigned int first = Vector_size(heap->data_);
+    Vector_recap(heap->data_, first + count);
+    for(unsigned int i = 0; i < count; i++){
+        HeapNode_* item = Heap_node_create_(keys[i], owns_keys, values == NULL ? NULL : values[i], owns_values);
+        item->position = first + i;
+        Vector_emplace_back(heap->data_, item, true);
+    }
+    Heap_restore_(heap, first);
+}
+
+void Heap_merge(Heap* heap, Heap* source){
+    const unsigned int first = Vector_size(heap->data_);
+    Vector_splice_back(heap->data_, source->data_);
+    const unsigned int size = Vector_size(heap->data_);
+    for(unsigned int i = first; i < size; i++) Heap_at_(heap, i)->position = i;
+    Heap_restore_(heap, first);
 }
 
 void Heap_pop(Heap* heap){
+    Profile_operation_(ProfileKind_Heap);
     if(Vector_empty(heap->data_)) return;
-    Vector_swap(heap->data_, 0, Vector_size(heap->data_) - 1);
+    Heap_swap_(heap, 0, Vector_size(heap->data_) - 1);
     Vector_pop_back(heap->data_);
-    Heap_sink_(heap);
+    if(!Vector_empty(heap->data_)) Heap_sink_(heap, 0);
+}
+
+bool Heap_pop_into(Heap* heap, void** key, void** value){
+    if(Vector_empty(heap->data_)) return false;
+    KeyValue* entry = &Heap_at_(heap, 0)->entry;
+    if(key != NULL){
+        *key = entry->key;
+        entry->key_owned = false;
+    }
+    if(value != NULL){
+        *value = entry->value;
+        entry->value_owned = false;
+    }
+    Heap_pop(heap);
+    return true;
 }
 
 void* Heap_top(Heap* heap){
+    Profile_operation_(ProfileKind_Heap);
     if(Vector_empty(heap->data_)) return NULL;
-    return ((KeyValue*)Vector_at(heap->data_, 0))->value;
+    return Heap_at_(heap, 0)->entry.value;
+}
+
+KeyValue* Heap_top_entry(Heap* heap){
+    Profile_operation_(ProfileKind_Heap);
+    if(Vector_empty(heap->data_)) return NULL;
+    return &Heap_at_(heap, 0)->entry;
+}
+
+void Heap_decrease_key(Heap* heap, KeyValue* entry, void* key, bool owns_key){
+    Profile_operation_(ProfileKind_Heap);
+    Heap_replace_key_(entry, key, owns_key);
+    Heap_swim_(heap, ((HeapNode_*)entry)->position);
+}
+
+void Heap_update(Heap* heap, KeyValue* entry, void* key, bool owns_key){
+    Profile_operation_(ProfileKind_Heap);
+    Heap_replace_key_(entry, key, owns_key);
+    const unsigned int position = ((HeapNode_*)entry)->position;
+    if(Heap_swim_(heap, position) == position) Heap_sink_(heap, position);
+}
+
+void Heap_erase(Heap* heap, KeyValue* entry){
+    Profile_operation_(ProfileKind_Heap);
+    const unsigned int position = ((HeapNode_*)entry)->position;
+    const unsigned int last = Vector_size(heap->data_) - 1;
+    Heap_swap_(heap, position, last);
+    Vector_pop_back(heap->data_);
+    // the element moved into the vacancy may violate the order in either direction
+    if(position != last && Heap_swim_(heap, position) == position) Heap_sink_(heap, position);
+}
+
+void Heap_foreach(Heap* heap, void (*visit)(KeyValue* entry, void* context), void* context){
+    const unsigned int size = Vector_size(heap->data_);
+    for(unsigned int i = 0; i < size; i++) visit(&Heap_at_(heap, i)->entry, context);
 }
\ No newline at end of file
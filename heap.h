@@ -1,5 +1,6 @@
 #ifndef CxKANOAXDP_heap_H_
 #define CxKANOAXDP_heap_H_
+#include "keyvalue_pair.h"
 #include <stdbool.h>
 // heap which support data of any type and any order specified when creating the heap
 typedef struct Heap Heap;
@@ -17,11 +18,48 @@ inline unsigned int Heap_size(Heap* heap);
 // insert a new element to heap
 //  the owns_{key, value} parameter specify if the {key, value} shall be managed, that is generally about
 //   deallocating the object. In case the object is managed, it must be a RAII object
-void Heap_insert(Heap* heap, void* key, bool owns_key, void* value, bool owns_value);
+//  return the entry inserted, which serves as a handle to the element until it is removed from heap
+KeyValue* Heap_insert(Heap* heap, void* key, bool owns_key, void* value, bool owns_value);
+
+// insert multiple elements to heap at once, which takes linear time with respect to the size of heap
+//  keys and values are arrays of count elements, values may be NULL in which case all values are NULL
+//  ownership is specified for all keys or all values together in the same way as Heap_insert
+void Heap_build(Heap* heap, void** keys, bool owns_keys, void** values, bool owns_values, unsigned int count);
+
+// move all elements from source to heap, leaving source empty
+//  both heaps must be arranged in the same order. Handles to elements of source remain valid and refer to
+//   the same elements in heap afterwards
+void Heap_merge(Heap* heap, Heap* source);
 
 // remove the element at the top of heap
 void Heap_pop(Heap* heap);
 
+// remove the element at the top of heap, handing its key and value to the caller
+//  ownership of the key or value is transferred to the caller if the corresponding pointer is not NULL,
+//   otherwise it is deallocated as Heap_pop does if managed
+//  return if there was an element to remove
+bool Heap_pop_into(Heap* heap, void** key, void** value);
+
 // get the element at the top of heap
 void* Heap_top(Heap* heap);
+
+// get the entry at the top of heap, return NULL if heap is empty
+KeyValue* Heap_top_entry(Heap* heap);
+
+// replace key of an entry in heap with a key that is not greater than the current one
+//  the entry must be a handle returned by Heap_insert on the same heap. If the current key is managed and
+//   differs from the new one, it is deallocated
+void Heap_decrease_key(Heap* heap, KeyValue* entry, void* key, bool owns_key);
+
+// replace key of an entry in heap with a key of any order, then restore the order of heap
+//  passing the current key again is allowed, which is useful after the key is modified in place
+void Heap_update(Heap* heap, KeyValue* entry, void* key, bool owns_key);
+
+// remove an entry from heap, the entry must be a handle returned by Heap_insert on the same heap
+void Heap_erase(Heap* heap, KeyValue* entry);
+
+// call visit on every entry in heap along with context
+//  entries are visited in the order they are laid out in heap, the top first, so that Heap_build given
+//   elements in this order keeps them where they are. The heap must not be modified meanwhile
+void Heap_foreach(Heap* heap, void (*visit)(KeyValue* entry, void* context), void* context);
 #endif
\ No newline at end of file
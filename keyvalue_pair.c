@@ -1,4 +1,5 @@
 #include "keyvalue_pair.h"
+#include "memory.h"
 // deleter for a key-value pair
 static void KeyValue_deleter_(void* target_){
     KeyValue* target = (KeyValue*)target_;
@@ -7,12 +8,15 @@ static void KeyValue_deleter_(void* target_){
     // deallocate the value if owned
     if(target->value_owned) RAII_delete(target->value);
 }
-KeyValue* KeyValue_create(void* key, bool owns_key, void* value, bool owns_value){
-    KeyValue* entry = (KeyValue*)malloc(sizeof(KeyValue));
+void KeyValue_initialize(KeyValue* entry, void* key, bool owns_key, void* value, bool owns_value){
     entry->key = key;
     entry->value = value;
     entry->key_owned = owns_key;
     entry->value_owned = owns_value;
     RAII_set_deleter(entry, KeyValue_deleter_);
+}
+KeyValue* KeyValue_create(void* key, bool owns_key, void* value, bool owns_value){
+    KeyValue* entry = (KeyValue*)Memory_allocate_object(sizeof(KeyValue));
+    KeyValue_initialize(entry, key, owns_key, value, owns_value);
     return entry;
 }
\ No newline at end of file
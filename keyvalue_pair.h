@@ -10,6 +10,10 @@ typedef struct{
     bool key_owned;
     bool value_owned;
 }KeyValue;
+// initialize a key-value pair, setting up fields and deleter
+//  ownership of key and value can be set separately
+void KeyValue_initialize(KeyValue* entry, void* key, bool owns_key, void* value, bool owns_value);
+
 // create a new key-value pair
 //  ownership of key and value can be set separately
 KeyValue* KeyValue_create(void* key, bool owns_key, void* value, bool owns_value);
@@ -1,10 +1,14 @@
 #include "list.h"
+#include "memory.h"
+#include "profile.h"
+#include "reclaimer.h"
 // deleter used in case the list node owns the data stored within
 static void ListNode_deleter_(void* target_){
     RAII_delete(((ListNode*)target_)->data);
 }
 ListNode* ListNode_create(void* data, bool owned){
-    ListNode* list_node = (ListNode*)malloc(sizeof(ListNode));
+    Profile_allocating_(ProfileKind_List);
+    ListNode* list_node = (ListNode*)Memory_allocate_object(sizeof(ListNode));
     list_node->data = data;
     list_node->next = NULL;
     list_node->prev = NULL;
@@ -20,7 +24,8 @@ void List_initialize(List* list){
     RAII_set_deleter(list, (void(*)(void*))List_clear);
 }
 List* List_create(){
-    List* list = (List*)malloc(sizeof(List));
+    Profile_allocating_(ProfileKind_List);
+    List* list = (List*)Memory_allocate_object(sizeof(List));
     List_initialize(list);
     return list;
 }
@@ -34,6 +39,18 @@ void List_clear(List* list){
     }
     List_initialize(list);
 }
+void List_clear_deferred(List* list){
+    if(List_empty(list)) return;
+    // nodes are moved to a list of their own by relinking the ends to its head
+    List* detached = List_create();
+    detached->head.next = list->head.next;
+    detached->head.prev = list->head.prev;
+    detached->head.next->prev = &detached->head;
+    detached->head.prev->next = &detached->head;
+    detached->size = list->size;
+    List_initialize(list);
+    Reclaimer_defer(detached);
+}
 bool List_empty(const List* list){
     return list->head.next == &(list->head);
 }
@@ -47,6 +64,7 @@ ListNode* List_emplace_back(List* list, ListNode* list_node){
     return List_emplace_before(list, list_node, &list->head);
 }
 ListNode* List_emplace_after(List* list, ListNode* insert, ListNode* after){
+    Profile_operation_(ProfileKind_List);
     insert->next = after->next;
     after->next->prev = insert;
     after->next = insert;
@@ -55,6 +73,7 @@ ListNode* List_emplace_after(List* list, ListNode* insert, ListNode* after){
     return insert;
 }
 ListNode* List_emplace_before(List* list, ListNode* insert, ListNode* before){
+    Profile_operation_(ProfileKind_List);
     insert->prev = before->prev;
     before->prev = insert;
     insert->next = before;
@@ -63,6 +82,7 @@ ListNode* List_emplace_before(List* list, ListNode* insert, ListNode* before){
     return insert;
 }
 void List_detach(List* list, ListNode* list_node){
+    Profile_operation_(ProfileKind_List);
     if(list->size == 0) return;
     list_node->prev->next = list_node->next;
     list_node->next->prev = list_node->prev;
@@ -77,6 +97,7 @@ bool List_default_comparator(const void* data, const void* rhs){
     return data == rhs;
 }
 ListNode* List_find(List* list, const void* data, bool (*comparator)(const void* data, const void* rhs)){
+    Profile_operation_(ProfileKind_List);
     if(comparator == NULL) comparator = List_default_comparator;
     for(ListNode* node = list->head.next; node != &list->head; node = node->next){
         if(comparator(data, node->data)) return node;
@@ -32,6 +32,9 @@ List* List_create();
 // remove all elements in list, invoking deleter of each of them
 void List_clear(List* list);
 
+// remove all elements in list in constant time, handing them over to the reclaimer thread to be deleted
+void List_clear_deferred(List* list);
+
 // check if a list is empty
 inline bool List_empty(const List* list);
 
@@ -0,0 +1,90 @@
+#include "memory.h"
+#include "arena.h"
+#include "chunk.h"
+#include "profile.h"
+#include "slab.h"
+#include "standard_fix.h"
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdlib.h>
+static void* Allocator_system_allocate_(Unused void* context, size_t size, size_t alignment){
+    if(alignment <= alignof(max_align_t)) return malloc(size);
+    // aligned_alloc requires size to be a multiple of alignment
+    return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+}
+
+static void* Allocator_system_reallocate_(Unused void* context, void* block, size_t size){
+    return realloc(block, size);
+}
+
+static void Allocator_system_release_(Unused void* context, void* block){
+    free(block);
+}
+
+const Allocator Allocator_system = {
+    .allocate = Allocator_system_allocate_,
+    .reallocate = Allocator_system_reallocate_,
+    .release = Allocator_system_release_,
+    .context = NULL,
+};
+static const Allocator* Memory_allocator_ = &Allocator_system;
+
+void Memory_set_allocator(const Allocator* allocator){
+    Memory_allocator_ = allocator != NULL ? allocator : &Allocator_system;
+}
+
+const Allocator* Memory_allocator(void){
+    return Memory_allocator_;
+}
+
+// record an allocation when built with the profiling option, return block
+static inline void* Memory_profile_(void* block, Unused size_t size, Unused bool tracked){
+    #if BASE_PROFILING
+    Profile_allocated_(block, size, tracked);
+    #endif
+    return block;
+}
+
+void* Memory_allocate_object(size_t size){
+    Arena* arena = Arena_current();
+    if(arena != NULL) return Memory_profile_(Arena_allocate(arena, size), size, false);
+    if(size <= Slab_MaxSize) return Memory_profile_(Slab_allocate(size), size, true);
+    return Memory_profile_(
+        Memory_allocator_->allocate(Memory_allocator_->context, size, alignof(max_align_t)), size, true
+    );
+}
+
+void* Memory_allocate(size_t size){
+    Arena* arena = Arena_current();
+    if(arena != NULL) return Memory_profile_(Arena_allocate_block(arena, size), size, false);
+    return Memory_profile_(
+        Memory_allocator_->allocate(Memory_allocator_->context, size, alignof(max_align_t)), size, true
+    );
+}
+
+void* Memory_allocate_aligned(size_t size, size_t alignment){
+    if(alignment < alignof(max_align_t)) alignment = alignof(max_align_t);
+    return Memory_profile_(Memory_allocator_->allocate(Memory_allocator_->context, size, alignment), size, true);
+}
+
+void* Memory_reallocate(void* block, size_t size){
+    if(block == NULL) return Memory_allocate(size);
+    ChunkOwner* owner = Chunk_owner(block);
+    void* resized;
+    if(owner != NULL) resized = owner->reallocate(owner, block, size);
+    else resized = Memory_allocator_->reallocate(Memory_allocator_->context, block, size);
+    #if BASE_PROFILING
+    Profile_reallocated_(block, resized, size);
+    #endif
+    return resized;
+}
+
+void Memory_release(void* object){
+    if(object == NULL) return;
+    #if BASE_PROFILING
+    Profile_released_(object);
+    #endif
+    ChunkOwner* owner = Chunk_owner(object);
+    if(owner != NULL) owner->release(owner, object);
+    else Memory_allocator_->release(Memory_allocator_->context, object);
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef CxKANOAXDP_memory_H_
+#define CxKANOAXDP_memory_H_
+#include <stddef.h>
+// allocation of objects and arrays managed by the library
+//  small objects come from slabs cached per thread, which is much faster than malloc and keeps objects of
+//   the same size together. Larger objects and arrays, as well as chunks slabs are carved out of, come from
+//   the allocator set, which is malloc unless replaced with Memory_set_allocator
+//  while the calling thread is in scope of an arena, objects and arrays come from the arena instead, so that
+//   an arena created with an allocator of its own places everything created in its scope there
+//  RAII_delete releases objects this way, therefore RAII objects may be allocated by either
+//   Memory_allocate_object or the allocator set, but memory from this module must never be passed to free
+
+// source of memory such as jemalloc arenas, NUMA-local pools or huge-page regions, which works in the same
+//  way as malloc, realloc and free with context passed to each call
+//  allocate returns memory aligned to alignment, which is a power of 2 no less than alignof(max_align_t)
+//  reallocate is only called on blocks allocated with alignment of alignof(max_align_t)
+typedef struct{
+    void* (*allocate)(void* context, size_t size, size_t alignment);
+    void* (*reallocate)(void* context, void* block, size_t size);
+    void (*release)(void* context, void* block);
+    void* context;
+}Allocator;
+
+// the allocator based on malloc, realloc, aligned_alloc and free
+extern const Allocator Allocator_system;
+
+// set the allocator of the library, NULL to restore Allocator_system
+//  memory is released to the allocator set at the time, therefore this shall be called before anything is
+//   allocated by the library, and before other threads are started
+//  allocator must stay valid until the library is no longer used
+//  RAII_delete releases objects to the allocator set as well, so that once another allocator is set, RAII
+//   objects of the user shall be allocated by Memory_allocate_object or that allocator instead of malloc
+void Memory_set_allocator(const Allocator* allocator);
+
+// get the allocator of the library
+const Allocator* Memory_allocator(void);
+
+// allocate memory for an object of specified size, aligned for any object of that size
+//  return NULL if out of memory
+void* Memory_allocate_object(size_t size);
+
+// allocate memory for an array of specified size in bytes, which may be resized by Memory_reallocate
+//  return NULL if out of memory
+void* Memory_allocate(size_t size);
+
+// allocate memory of specified size aligned to alignment, which is a power of 2, from the allocator set
+//  arenas are bypassed, memory is always returned to the allocator by Memory_release
+//  return NULL if out of memory
+void* Memory_allocate_aligned(size_t size, size_t alignment);
+
+// resize an array allocated by Memory_allocate, which may move it, allocate it if NULL
+//  an array is resized where it was allocated, even if the thread has entered or left arenas since then
+//  return NULL if out of memory, in which case the array is left as is
+void* Memory_reallocate(void* block, size_t size);
+
+// release memory of an object or array allocated by this module or the allocator set, NULL is ignored
+void Memory_release(void* object);
+#endif
\ No newline at end of file
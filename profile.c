@@ -0,0 +1,366 @@
+#include "profile.h"
+#include "standard_fix.h"
+#include <limits.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#if BASE_PROFILING && defined(__has_include)
+#if __has_include(<execinfo.h>)
+#define Profile_Backtrace_ 1
+#include <execinfo.h>
+#endif
+#endif
+#ifndef Profile_Backtrace_
+#define Profile_Backtrace_ 0
+#endif
+static const char* const ProfileKind_names_[ProfileKind_Count] = {
+    "Other", "List", "Vector", "Heap", "HashTable", "FlatHashTable", "ConcurrentHashTable", "ConcurrentHeap",
+    "RadixHeap", "TimingWheel", "TopK", "Cache", "BitIO", "BTree",
+};
+
+const char* ProfileKind_name(enum ProfileKind kind){
+    return kind < ProfileKind_Count ? ProfileKind_names_[kind] : "Unknown";
+}
+
+#if BASE_PROFILING
+enum Profile_InternalConstant{
+    Profile_OperationSlots = 16,    // number of counters operations are spread over, threads take them in turn
+    Profile_Stripes = 64,           // number of independently locked parts of the table of live blocks
+    Profile_StripeBits = 6,
+    Profile_MinBlocks = 64,         // least capacity of each part of the table of live blocks
+};
+typedef struct{
+    alignas(64) atomic_size_t allocations;
+    atomic_size_t frees;
+    atomic_size_t reallocations;
+    atomic_size_t bytes_allocated;
+    atomic_size_t bytes_freed;
+    atomic_size_t live_bytes;
+    atomic_size_t peak_bytes;
+}ProfileCounters_;
+// operations are counted far more often than memory, so threads count them in separate cache lines
+typedef struct{
+    alignas(64) atomic_size_t counts[ProfileKind_Count];
+}ProfileOperations_;
+// live block, whose size and kind are needed when it is freed
+typedef struct{
+    void* address;
+    size_t size;
+    enum ProfileKind kind;
+}ProfileBlock_;
+// part of the table of live blocks, an open addressing hash table with linear probing
+typedef struct{
+    alignas(64) mtx_t lock;
+    ProfileBlock_* blocks;
+    size_t capacity;
+    size_t count;
+}ProfileStripe_;
+_Thread_local enum ProfileKind Profile_kind_ = ProfileKind_Other;
+static ProfileCounters_ Profile_kinds_[ProfileKind_Count];
+static ProfileCounters_ Profile_total_;
+static ProfileOperations_ Profile_operations_[Profile_OperationSlots];
+static ProfileStripe_ Profile_stripes_[Profile_Stripes];
+static once_flag Profile_once_ = ONCE_FLAG_INIT;
+static atomic_uint Profile_period_ = 0;
+static _Thread_local unsigned int Profile_countdown_ = 0;
+// latest samples in a ring, next is where the next one goes
+static mtx_t Profile_samples_lock_;
+static ProfileSample Profile_samples_[Profile_Samples];
+static size_t Profile_samples_next_ = 0;
+static size_t Profile_samples_count_ = 0;
+
+static void Profile_initialize_(void){
+    for(unsigned int i = 0; i < Profile_Stripes; i++) mtx_init(&Profile_stripes_[i].lock, mtx_plain);
+    mtx_init(&Profile_samples_lock_, mtx_plain);
+}
+
+// mix bits of address into a hash whose top bits choose the stripe, and low bits the line within it
+static inline uint64_t Profile_hash_(const void* address){
+    uint64_t hash = (uint64_t)(uintptr_t)address;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static inline ProfileStripe_* Profile_stripe_(uint64_t hash){
+    return Profile_stripes_ + (hash >> (64 - Profile_StripeBits));
+}
+
+// put a block into a stripe known to have room, stripe must be locked
+static void Profile_stripe_put_(ProfileStripe_* stripe, ProfileBlock_ block){
+    size_t line = Profile_hash_(block.address) & (stripe->capacity - 1);
+    while(stripe->blocks[line].address != NULL) line = (line + 1) & (stripe->capacity - 1);
+    stripe->blocks[line] = block;
+    stripe->count += 1;
+}
+
+// record a live block, stripe must be locked
+//  the table is allocated by calloc rather than the memory module, which would record it again
+static void Profile_track_(ProfileStripe_* stripe, ProfileBlock_ block){
+    if((stripe->count + 1) * 2 > stripe->capacity){
+        ProfileBlock_* blocks = stripe->blocks;
+        const size_t capacity = stripe->capacity;
+        stripe->capacity = capacity == 0 ? Profile_MinBlocks : capacity << 1;
+        stripe->blocks = (ProfileBlock_*)calloc(stripe->capacity, sizeof(ProfileBlock_));
+        stripe->count = 0;
+        for(size_t i = 0; i < capacity; i++){
+            if(blocks[i].address != NULL) Profile_stripe_put_(stripe, blocks[i]);
+        }
+        free(blocks);
+    }
+    Profile_stripe_put_(stripe, block);
+}
+
+// remove a live block, stripe must be locked
+//  return if the block is found, along with what is recorded of it
+static bool Profile_untrack_(ProfileStripe_* stripe, void* address, ProfileBlock_* block){
+    if(stripe->capacity == 0) return false;
+    const size_t mask = stripe->capacity - 1;
+    size_t line = Profile_hash_(address) & mask;
+    while(stripe->blocks[line].address != address){
+        if(stripe->blocks[line].address == NULL) return false;
+        line = (line + 1) & mask;
+    }
+    *block = stripe->blocks[line];
+    // shift back later blocks of the cluster which would no longer be found past the hole
+    for(size_t next = (line + 1) & mask; stripe->blocks[next].address != NULL; next = (next + 1) & mask){
+        const size_t home = Profile_hash_(stripe->blocks[next].address) & mask;
+        if(((next - home) & mask) >= ((next - line) & mask)){
+            stripe->blocks[line] = stripe->blocks[next];
+            line = next;
+        }
+    }
+    stripe->blocks[line].address = NULL;
+    stripe->count -= 1;
+    return true;
+}
+
+// raise peak to live if it is higher
+static inline void Profile_raise_peak_(atomic_size_t* peak, size_t live){
+    size_t observed = atomic_load_explicit(peak, memory_order_relaxed);
+    while(live > observed && !atomic_compare_exchange_weak_explicit(
+        peak, &observed, live, memory_order_relaxed, memory_order_relaxed
+    ));
+}
+
+// add to live bytes of counters, raising the peak
+static inline void Profile_add_live_(ProfileCounters_* counters, size_t size){
+    const size_t live = atomic_fetch_add_explicit(&counters->live_bytes, size, memory_order_relaxed) + size;
+    Profile_raise_peak_(&counters->peak_bytes, live);
+}
+
+// count bytes allocated for a kind and in total
+static void Profile_count_allocated_(enum ProfileKind kind, size_t size, bool tracked){
+    ProfileCounters_* counters[] = {Profile_kinds_ + kind, &Profile_total_};
+    for(unsigned int i = 0; i < 2; i++){
+        atomic_fetch_add_explicit(&counters[i]->bytes_allocated, size, memory_order_relaxed);
+        if(tracked) Profile_add_live_(counters[i], size);
+    }
+}
+
+// count bytes of a tracked block freed for its kind and in total
+static void Profile_count_freed_(const ProfileBlock_* block){
+    ProfileCounters_* counters[] = {Profile_kinds_ + block->kind, &Profile_total_};
+    for(unsigned int i = 0; i < 2; i++){
+        atomic_fetch_add_explicit(&counters[i]->bytes_freed, block->size, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&counters[i]->live_bytes, block->size, memory_order_relaxed);
+    }
+}
+
+// take a sample of call stack if calling thread is due to
+static void Profile_sample_(enum ProfileKind kind, size_t size){
+    const unsigned int period = atomic_load_explicit(&Profile_period_, memory_order_relaxed);
+    if(period == 0) return;
+    if(Profile_countdown_ == 0 || Profile_countdown_ > period) Profile_countdown_ = period;
+    if(--Profile_countdown_ > 0) return;
+    ProfileSample sample = {.kind = kind, .size = size, .depth = 0};
+    #if Profile_Backtrace_
+    const int depth = backtrace(sample.frames, Profile_Frames);
+    sample.depth = depth > 0 ? (unsigned int)depth : 0;
+    #endif
+    mtx_lock(&Profile_samples_lock_);
+    Profile_samples_[Profile_samples_next_] = sample;
+    Profile_samples_next_ = (Profile_samples_next_ + 1) % Profile_Samples;
+    if(Profile_samples_count_ < Profile_Samples) Profile_samples_count_ += 1;
+    mtx_unlock(&Profile_samples_lock_);
+}
+
+void Profile_count_operation_(enum ProfileKind kind){
+    static atomic_uint next_slot = 0;
+    static _Thread_local unsigned int slot = UINT_MAX;
+    if(slot == UINT_MAX){
+        slot = atomic_fetch_add_explicit(&next_slot, 1, memory_order_relaxed) % Profile_OperationSlots;
+    }
+    atomic_fetch_add_explicit(Profile_operations_[slot].counts + kind, 1, memory_order_relaxed);
+}
+
+void Profile_allocated_(void* block, size_t size, bool tracked){
+    const enum ProfileKind kind = Profile_kind_;
+    Profile_kind_ = ProfileKind_Other;
+    if(block == NULL) return;
+    call_once(&Profile_once_, Profile_initialize_);
+    atomic_fetch_add_explicit(&Profile_kinds_[kind].allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&Profile_total_.allocations, 1, memory_order_relaxed);
+    Profile_count_allocated_(kind, size, tracked);
+    if(tracked){
+        ProfileStripe_* stripe = Profile_stripe_(Profile_hash_(block));
+        mtx_lock(&stripe->lock);
+        Profile_track_(stripe, (ProfileBlock_){.address = block, .size = size, .kind = kind});
+        mtx_unlock(&stripe->lock);
+    }
+    Profile_sample_(kind, size);
+}
+
+void Profile_reallocated_(void* previous, void* block, size_t size){
+    enum ProfileKind kind = Profile_kind_;
+    Profile_kind_ = ProfileKind_Other;
+    if(block == NULL) return;
+    call_once(&Profile_once_, Profile_initialize_);
+    ProfileBlock_ recorded;
+    ProfileStripe_* stripe = Profile_stripe_(Profile_hash_(previous));
+    mtx_lock(&stripe->lock);
+    const bool tracked = Profile_untrack_(stripe, previous, &recorded);
+    mtx_unlock(&stripe->lock);
+    // an array stays with the kind it is allocated for
+    if(tracked){
+        kind = recorded.kind;
+        Profile_count_freed_(&recorded);
+        stripe = Profile_stripe_(Profile_hash_(block));
+        mtx_lock(&stripe->lock);
+        Profile_track_(stripe, (ProfileBlock_){.address = block, .size = size, .kind = kind});
+        mtx_unlock(&stripe->lock);
+    }
+    atomic_fetch_add_explicit(&Profile_kinds_[kind].reallocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&Profile_total_.reallocations, 1, memory_order_relaxed);
+    Profile_count_allocated_(kind, size, tracked);
+}
+
+void Profile_released_(void* block){
+    call_once(&Profile_once_, Profile_initialize_);
+    ProfileBlock_ recorded;
+    ProfileStripe_* stripe = Profile_stripe_(Profile_hash_(block));
+    mtx_lock(&stripe->lock);
+    const bool tracked = Profile_untrack_(stripe, block, &recorded);
+    mtx_unlock(&stripe->lock);
+    if(!tracked) return;
+    atomic_fetch_add_explicit(&Profile_kinds_[recorded.kind].frees, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&Profile_total_.frees, 1, memory_order_relaxed);
+    Profile_count_freed_(&recorded);
+}
+
+// read counters into a snapshot
+static void Profile_load_(const ProfileCounters_* counters, ProfileCounters* loaded){
+    *loaded = (ProfileCounters){
+        .allocations = atomic_load_explicit(&counters->allocations, memory_order_relaxed),
+        .frees = atomic_load_explicit(&counters->frees, memory_order_relaxed),
+        .reallocations = atomic_load_explicit(&counters->reallocations, memory_order_relaxed),
+        .bytes_allocated = atomic_load_explicit(&counters->bytes_allocated, memory_order_relaxed),
+        .bytes_freed = atomic_load_explicit(&counters->bytes_freed, memory_order_relaxed),
+        .live_bytes = atomic_load_explicit(&counters->live_bytes, memory_order_relaxed),
+        .peak_bytes = atomic_load_explicit(&counters->peak_bytes, memory_order_relaxed),
+    };
+}
+
+// reset counters but live bytes
+static void Profile_clear_(ProfileCounters_* counters){
+    atomic_store_explicit(&counters->allocations, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->frees, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->reallocations, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->bytes_allocated, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->bytes_freed, 0, memory_order_relaxed);
+    atomic_store_explicit(
+        &counters->peak_bytes, atomic_load_explicit(&counters->live_bytes, memory_order_relaxed),
+        memory_order_relaxed
+    );
+}
+#endif
+
+void Profile_snapshot(ProfileSnapshot* snapshot){
+    *snapshot = (ProfileSnapshot){0};
+    #if BASE_PROFILING
+    for(unsigned int kind = 0; kind < ProfileKind_Count; kind++){
+        Profile_load_(Profile_kinds_ + kind, snapshot->kinds + kind);
+        for(unsigned int slot = 0; slot < Profile_OperationSlots; slot++){
+            snapshot->kinds[kind].operations += atomic_load_explicit(
+                Profile_operations_[slot].counts + kind, memory_order_relaxed
+            );
+        }
+        snapshot->total.operations += snapshot->kinds[kind].operations;
+    }
+    const size_t operations = snapshot->total.operations;
+    Profile_load_(&Profile_total_, &snapshot->total);
+    snapshot->total.operations = operations;
+    #endif
+}
+
+void Profile_reset(void){
+    #if BASE_PROFILING
+    for(unsigned int kind = 0; kind < ProfileKind_Count; kind++) Profile_clear_(Profile_kinds_ + kind);
+    Profile_clear_(&Profile_total_);
+    for(unsigned int slot = 0; slot < Profile_OperationSlots; slot++){
+        for(unsigned int kind = 0; kind < ProfileKind_Count; kind++){
+            atomic_store_explicit(Profile_operations_[slot].counts + kind, 0, memory_order_relaxed);
+        }
+    }
+    #endif
+}
+
+void Profile_set_sampling(Unused unsigned int period){
+    #if BASE_PROFILING
+    call_once(&Profile_once_, Profile_initialize_);
+    atomic_store_explicit(&Profile_period_, period, memory_order_relaxed);
+    #endif
+}
+
+size_t Profile_samples(Unused ProfileSample* samples, Unused size_t capacity){
+    size_t count = 0;
+    #if BASE_PROFILING
+    call_once(&Profile_once_, Profile_initialize_);
+    mtx_lock(&Profile_samples_lock_);
+    for(size_t i = 1; i <= Profile_samples_count_ && count < capacity; i++){
+        samples[count++] = Profile_samples_[(Profile_samples_next_ + Profile_Samples - i) % Profile_Samples];
+    }
+    mtx_unlock(&Profile_samples_lock_);
+    #endif
+    return count;
+}
+
+// print a line of counters
+static void Profile_dump_counters_(FILE* stream, const char* name, const ProfileCounters* counters){
+    fprintf(
+        stream, "[Profile]: %s: allocations %zu, frees %zu, reallocations %zu, bytes allocated %zu, "
+        "bytes freed %zu, live %zu, peak %zu, operations %zu\n",
+        name, counters->allocations, counters->frees, counters->reallocations, counters->bytes_allocated,
+        counters->bytes_freed, counters->live_bytes, counters->peak_bytes, counters->operations
+    );
+}
+
+void Profile_dump(FILE* stream){
+    ProfileSnapshot snapshot;
+    Profile_snapshot(&snapshot);
+    for(unsigned int kind = 0; kind < ProfileKind_Count; kind++){
+        const ProfileCounters* counters = snapshot.kinds + kind;
+        if(counters->allocations == 0 && counters->live_bytes == 0 && counters->operations == 0) continue;
+        Profile_dump_counters_(stream, ProfileKind_name(kind), counters);
+    }
+    Profile_dump_counters_(stream, "total", &snapshot.total);
+    ProfileSample samples[Profile_Samples];
+    const size_t count = Profile_samples(samples, Profile_Samples);
+    for(size_t i = 0; i < count; i++){
+        fprintf(
+            stream, "[Profile]: sample %zu: %s, %zu bytes\n", i, ProfileKind_name(samples[i].kind), samples[i].size
+        );
+        #if Profile_Backtrace_
+        char** symbols = backtrace_symbols(samples[i].frames, (int)samples[i].depth);
+        for(unsigned int frame = 0; frame < samples[i].depth; frame++){
+            if(symbols != NULL) fprintf(stream, "[Profile]:  %s\n", symbols[frame]);
+            else fprintf(stream, "[Profile]:  %p\n", samples[i].frames[frame]);
+        }
+        free(symbols);
+        #endif
+    }
+}
\ No newline at end of file
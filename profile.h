@@ -0,0 +1,99 @@
+#ifndef CxKANOAXDP_profile_H_
+#define CxKANOAXDP_profile_H_
+#include "baSe_config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+// profile of memory and operations of the library by kind of container, maintained only when built with the
+//  profiling option, otherwise all counters stay zero and hooks compile to nothing
+//  allocations are attributed to the kind of container making them, e.g. the array of a heap counts under
+//   Vector as it is a vector's. Allocations from arenas count as allocated, but never as freed or live since
+//   they are reclaimed with their arenas
+//  operations count public calls inserting, finding, removing or accessing elements, including calls made by
+//   other containers, e.g. lines of a hash table are lists
+enum ProfileKind{
+    ProfileKind_Other,  // objects allocated by users through the memory module, and anything not listed
+    ProfileKind_List,
+    ProfileKind_Vector,
+    ProfileKind_Heap,
+    ProfileKind_HashTable,
+    ProfileKind_FlatHashTable,
+    ProfileKind_ConcurrentHashTable,
+    ProfileKind_ConcurrentHeap,
+    ProfileKind_RadixHeap,
+    ProfileKind_TimingWheel,
+    ProfileKind_TopK,
+    ProfileKind_Cache,
+    ProfileKind_BitIO,
+    ProfileKind_BTree,
+    ProfileKind_Count,
+};
+enum Profile_Constant{
+    Profile_Frames = 16,    // most frames of call stack kept in a sample
+    Profile_Samples = 64,   // number of latest samples kept
+};
+// counters of a kind of container, or of all of them
+typedef struct{
+    size_t allocations;
+    size_t frees;
+    // calls resizing arrays, such as Vector_recap growing a vector
+    size_t reallocations;
+    size_t bytes_allocated;
+    size_t bytes_freed;
+    // bytes allocated but not freed yet, and the most there have been since last reset
+    size_t live_bytes;
+    size_t peak_bytes;
+    size_t operations;
+}ProfileCounters;
+// profile as gathered by Profile_snapshot
+typedef struct{
+    ProfileCounters kinds[ProfileKind_Count];
+    // peak of total is that of all kinds together, which is no more than the sum of their peaks
+    ProfileCounters total;
+}ProfileSnapshot;
+// call stack of a sampled allocation
+typedef struct{
+    enum ProfileKind kind;
+    size_t size;
+    unsigned int depth;
+    void* frames[Profile_Frames];
+}ProfileSample;
+
+// get name of a kind of container
+const char* ProfileKind_name(enum ProfileKind kind);
+
+// take a snapshot of counters, which are read without stopping other threads
+void Profile_snapshot(ProfileSnapshot* snapshot);
+
+// reset all counters but live bytes, and peaks to live bytes, so that later snapshots cover a new period
+void Profile_reset(void);
+
+// sample call stack of one in every period allocations on each thread, 0 to stop sampling, which is the default
+//  sampling takes call stacks only where the C library can walk them, such as glibc
+void Profile_set_sampling(unsigned int period);
+
+// copy up to capacity latest samples, latest first, return number of samples copied
+size_t Profile_samples(ProfileSample* samples, size_t capacity);
+
+// print counters of kinds having any, and samples with symbols of their frames where available
+void Profile_dump(FILE* stream);
+
+#if BASE_PROFILING
+// kind of container the next allocation of calling thread is attributed to, reset to Other by each allocation
+extern _Thread_local enum ProfileKind Profile_kind_;
+// attribute the next allocation of calling thread to a kind of container
+#define Profile_allocating_(kind) (Profile_kind_ = (kind))
+// count an operation on a kind of container
+#define Profile_operation_(kind) Profile_count_operation_(kind)
+void Profile_count_operation_(enum ProfileKind kind);
+// record an allocation of size bytes made by the memory module, which is freed later only if tracked
+void Profile_allocated_(void* block, size_t size, bool tracked);
+// record an array resized to size bytes, which was previous
+void Profile_reallocated_(void* previous, void* block, size_t size);
+// record a block released to the memory module, ignored if not tracked
+void Profile_released_(void* block);
+#else
+#define Profile_allocating_(kind) ((void)0)
+#define Profile_operation_(kind) ((void)0)
+#endif
+#endif
\ No newline at end of file
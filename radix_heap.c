@@ -0,0 +1,176 @@
+#include "radix_heap.h"
+#include "bitops.h"
+#include "list.h"
+#include "memory.h"
+#include "profile.h"
+#include "RAII.h"
+enum RadixHeap_Constant{
+    RadixHeap_Buckets = 65,     // one bucket for keys equal to the last key and one for each bit
+};
+// element in radix heap, linked in the bucket it belongs to
+//  the list node must be the first member, its data field holds the value
+struct RadixHeapNode_{
+    ListNode link;
+    uint64_t key;
+    unsigned int bucket;
+};
+struct RadixHeap{
+    RAII _;
+    List buckets_[RadixHeap_Buckets];
+    // bit i is set if bucket i + 1 is not empty
+    uint64_t occupied_;
+    // key the buckets are relative to, which is the smallest key looked at or removed from top
+    //  no element has a smaller key
+    uint64_t base_;
+    // key of the last element removed from top, no key smaller than which is inserted
+    uint64_t last_;
+    size_t size_;
+};
+
+// deleter for an element which owns its value
+static void RadixHeapNode_deleter_(void* target_){
+    RAII_delete(((ListNode*)target_)->data);
+}
+
+// get index of the bucket a key belongs to
+static inline unsigned int RadixHeap_bucket_(RadixHeap* heap, uint64_t key){
+    if(key == heap->base_) return 0;
+    return 64 - BitOps_leading_zeros(key ^ heap->base_);
+}
+
+// put an element into the bucket it belongs to
+static void RadixHeap_place_(RadixHeap* heap, RadixHeapNode* node){
+    node->bucket = RadixHeap_bucket_(heap, node->key);
+    List_emplace_back(heap->buckets_ + node->bucket, &node->link);
+    if(node->bucket != 0) heap->occupied_ |= UINT64_C(1) << (node->bucket - 1);
+}
+
+// take an element out of its bucket without destroying it
+static void RadixHeap_detach_(RadixHeap* heap, RadixHeapNode* node){
+    List* bucket = heap->buckets_ + node->bucket;
+    List_detach(bucket, &node->link);
+    if(node->bucket != 0 && List_empty(bucket)) heap->occupied_ &= ~(UINT64_C(1) << (node->bucket - 1));
+}
+
+// make sure that the elements with the smallest key are in bucket 0, heap must not be empty
+//  the first non-empty bucket is emptied by moving base_ to its minimum and redistributing all its elements,
+//  which all go to buckets of smaller index
+static void RadixHeap_settle_(RadixHeap* heap){
+    if(!List_empty(heap->buckets_)) return;
+    List* bucket = heap->buckets_ + BitOps_trailing_zeros(heap->occupied_) + 1;
+    uint64_t least = ((RadixHeapNode*)bucket->head.next)->key;
+    for(ListNode* node = bucket->head.next; node != &bucket->head; node = node->next){
+        if(((RadixHeapNode*)node)->key < least) least = ((RadixHeapNode*)node)->key;
+    }
+    heap->base_ = least;
+    while(!List_empty(bucket)){
+        RadixHeapNode* node = (RadixHeapNode*)bucket->head.next;
+        RadixHeap_detach_(heap, node);
+        RadixHeap_place_(heap, node);
+    }
+}
+
+// move base_ back to a key smaller than it, which is not smaller than last_
+//  with d the highest bit in which the two bases differ, the old base has bit d set, so that no element is in
+//   bucket d + 1 and elements in buckets 0 to d all go there, while elements in higher buckets stay
+static void RadixHeap_rebase_(RadixHeap* heap, uint64_t key){
+    const unsigned int target = 64 - BitOps_leading_zeros(key ^ heap->base_);
+    heap->base_ = key;
+    for(unsigned int i = 0; i < target; i++){
+        List* bucket = heap->buckets_ + i;
+        while(!List_empty(bucket)){
+            RadixHeapNode* node = (RadixHeapNode*)bucket->head.next;
+            RadixHeap_detach_(heap, node);
+            node->bucket = target;
+            List_emplace_back(heap->buckets_ + target, &node->link);
+            heap->occupied_ |= UINT64_C(1) << (target - 1);
+        }
+    }
+}
+
+// destroy the heap
+static void RadixHeap_destroy_(RadixHeap* heap){
+    RadixHeap_clear(heap);
+}
+
+RadixHeap* RadixHeap_create(){
+    Profile_allocating_(ProfileKind_RadixHeap);
+    RadixHeap* heap = (RadixHeap*)Memory_allocate_object(sizeof(RadixHeap));
+    for(unsigned int i = 0; i < RadixHeap_Buckets; i++) List_initialize(heap->buckets_ + i);
+    heap->occupied_ = 0;
+    heap->base_ = 0;
+    heap->last_ = 0;
+    heap->size_ = 0;
+    RAII_set_deleter(heap, (void(*)(void*))RadixHeap_destroy_);
+    return heap;
+}
+
+void RadixHeap_clear(RadixHeap* heap){
+    for(unsigned int i = 0; i < RadixHeap_Buckets; i++) List_clear(heap->buckets_ + i);
+    heap->occupied_ = 0;
+    heap->base_ = 0;
+    heap->last_ = 0;
+    heap->size_ = 0;
+}
+
+size_t RadixHeap_size(RadixHeap* heap){
+    return heap->size_;
+}
+
+RadixHeapNode* RadixHeap_insert(RadixHeap* heap, uint64_t key, void* value, bool owns_value){
+    Profile_operation_(ProfileKind_RadixHeap);
+    #ifndef NDEBUG
+    if(key < heap->last_) fprintf(stderr, "[RadixHeap]: Inserting key smaller than the last key removed!\n");
+    #endif
+    Profile_allocating_(ProfileKind_RadixHeap);
+    RadixHeapNode* node = (RadixHeapNode*)Memory_allocate_object(sizeof(RadixHeapNode));
+    node->link.data = value;
+    if(owns_value) RAII_set_deleter(node, RadixHeapNode_deleter_);
+    else RAII_set_dummy_deleter(node);
+    node->key = key;
+    if(key < heap->base_) RadixHeap_rebase_(heap, key);
+    RadixHeap_place_(heap, node);
+    heap->size_ += 1;
+    return node;
+}
+
+void RadixHeap_cancel(RadixHeap* heap, RadixHeapNode* node){
+    Profile_operation_(ProfileKind_RadixHeap);
+    RadixHeap_detach_(heap, node);
+    RAII_delete(node);
+    heap->size_ -= 1;
+}
+
+void* RadixHeap_top(RadixHeap* heap){
+    Profile_operation_(ProfileKind_RadixHeap);
+    if(heap->size_ == 0) return NULL;
+    RadixHeap_settle_(heap);
+    return heap->buckets_[0].head.next->data;
+}
+
+uint64_t RadixHeap_top_key(RadixHeap* heap){
+    Profile_operation_(ProfileKind_RadixHeap);
+    RadixHeap_settle_(heap);
+    return ((RadixHeapNode*)heap->buckets_[0].head.next)->key;
+}
+
+void RadixHeap_pop(RadixHeap* heap){
+    if(heap->size_ == 0) return;
+    RadixHeap_settle_(heap);
+    heap->last_ = heap->base_;
+    RadixHeap_cancel(heap, (RadixHeapNode*)heap->buckets_[0].head.next);
+}
+
+bool RadixHeap_pop_into(RadixHeap* heap, uint64_t* key, void** value){
+    if(heap->size_ == 0) return false;
+    RadixHeap_settle_(heap);
+    RadixHeapNode* node = (RadixHeapNode*)heap->buckets_[0].head.next;
+    heap->last_ = heap->base_;
+    if(key != NULL) *key = node->key;
+    if(value != NULL){
+        *value = node->link.data;
+        RAII_set_dummy_deleter(node);
+    }
+    RadixHeap_cancel(heap, node);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef CxKANOAXDP_radix_heap_H_
+#define CxKANOAXDP_radix_heap_H_
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+// heap on unsigned integer keys which requires that no key smaller than the last key removed is inserted,
+//  as is the case with timestamps or distances in Dijkstra's algorithm
+//  elements are kept in buckets by the highest bit in which their keys differ from the smallest key looked at
+//  or removed, therefore no comparator is needed and each element is moved between buckets no more than 64
+//  times, unless keys smaller than the top looked at are inserted, which moves elements back to higher buckets
+typedef struct RadixHeap RadixHeap;
+
+// handle to an element in radix heap, valid until the element is removed
+typedef struct RadixHeapNode_ RadixHeapNode;
+
+// create a new radix heap
+RadixHeap* RadixHeap_create();
+
+// remove all elements from heap, this also lifts the restriction on keys to insert
+void RadixHeap_clear(RadixHeap* heap);
+
+// get number of elements in heap
+inline size_t RadixHeap_size(RadixHeap* heap);
+
+// insert a new element to heap
+//  key must not be smaller than the key of the last element removed from the top of heap, elements only
+//   looked at by RadixHeap_top or RadixHeap_top_key do not count
+//  the value is managed if owns_value is set, in which case it must be a RAII object
+//  return handle to the element inserted
+RadixHeapNode* RadixHeap_insert(RadixHeap* heap, uint64_t key, void* value, bool owns_value);
+
+// remove an element from heap by its handle
+void RadixHeap_cancel(RadixHeap* heap, RadixHeapNode* node);
+
+// get the value of the element at the top of heap, return NULL if heap is empty
+//  buckets are settled in the same way as removing the top, it is not removed though
+void* RadixHeap_top(RadixHeap* heap);
+
+// get the key of the element at the top of heap, heap must not be empty
+uint64_t RadixHeap_top_key(RadixHeap* heap);
+
+// remove the element at the top of heap
+void RadixHeap_pop(RadixHeap* heap);
+
+// remove the element at the top of heap, handing its key and value to the caller
+//  ownership of the value is transferred to the caller if value is not NULL
+//  return if there was an element to remove
+bool RadixHeap_pop_into(RadixHeap* heap, uint64_t* key, void** value);
+#endif
\ No newline at end of file
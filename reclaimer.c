@@ -0,0 +1,69 @@
+#include "reclaimer.h"
+#include "RAII.h"
+#include "arena.h"
+#include "list.h"
+#include "standard_fix.h"
+#include <stdbool.h>
+#include <threads.h>
+static once_flag Reclaimer_once_ = ONCE_FLAG_INIT;
+static mtx_t Reclaimer_lock_;
+// signaled when objects are handed over, and when all of them are deleted
+static cnd_t Reclaimer_wake_;
+static cnd_t Reclaimer_idle_;
+// nodes owning objects waiting to be deleted, oldest at front
+static List Reclaimer_queue_;
+// objects handed over but not deleted yet, including the one being deleted
+static size_t Reclaimer_pending_ = 0;
+static bool Reclaimer_started_ = false;
+
+// delete objects in queue one at a time, never returns
+static int Reclaimer_run_(Unused void* argument){
+    mtx_lock(&Reclaimer_lock_);
+    while(true){
+        while(List_empty(&Reclaimer_queue_)) cnd_wait(&Reclaimer_wake_, &Reclaimer_lock_);
+        ListNode* node = Reclaimer_queue_.head.next;
+        List_detach(&Reclaimer_queue_, node);
+        mtx_unlock(&Reclaimer_lock_);
+        RAII_delete(node);
+        mtx_lock(&Reclaimer_lock_);
+        Reclaimer_pending_ -= 1;
+        if(Reclaimer_pending_ == 0) cnd_broadcast(&Reclaimer_idle_);
+    }
+    return 0;
+}
+
+static void Reclaimer_start_(void){
+    mtx_init(&Reclaimer_lock_, mtx_plain);
+    cnd_init(&Reclaimer_wake_);
+    cnd_init(&Reclaimer_idle_);
+    List_initialize(&Reclaimer_queue_);
+    thrd_t thread;
+    if(thrd_create(&thread, Reclaimer_run_, NULL) != thrd_success) return;
+    thrd_detach(thread);
+    Reclaimer_started_ = true;
+}
+
+void Reclaimer_defer(void* object){
+    call_once(&Reclaimer_once_, Reclaimer_start_);
+    if(!Reclaimer_started_){
+        RAII_delete(object);
+        return;
+    }
+    // the node outlives any arena the calling thread is in
+    Arena* previous = Arena_enter(NULL);
+    ListNode* node = ListNode_create(object, true);
+    Arena_leave(previous);
+    mtx_lock(&Reclaimer_lock_);
+    List_emplace_back(&Reclaimer_queue_, node);
+    Reclaimer_pending_ += 1;
+    cnd_signal(&Reclaimer_wake_);
+    mtx_unlock(&Reclaimer_lock_);
+}
+
+void Reclaimer_drain(void){
+    call_once(&Reclaimer_once_, Reclaimer_start_);
+    if(!Reclaimer_started_) return;
+    mtx_lock(&Reclaimer_lock_);
+    while(Reclaimer_pending_ != 0) cnd_wait(&Reclaimer_idle_, &Reclaimer_lock_);
+    mtx_unlock(&Reclaimer_lock_);
+}
\ No newline at end of file
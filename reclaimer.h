@@ -0,0 +1,17 @@
+#ifndef CxKANOAXDP_reclaimer_H_
+#define CxKANOAXDP_reclaimer_H_
+// background thread deleting RAII objects handed to it, so that dropping large containers costs their owner
+//  constant time. The containers' *_clear_deferred functions detach contents and hand them over this way
+//  the thread is started on first use and serves all threads of the process in order of handing over
+//  deleters of elements run on the reclaimer thread, therefore they must not touch anything the handing
+//   thread keeps using without synchronization
+//  objects allocated from an arena must not be handed over unless Reclaimer_drain is called before deleting
+//   the arena
+
+// hand a RAII object over to be deleted with RAII_delete on the reclaimer thread
+//  the object is deleted before return if the thread cannot be started
+void Reclaimer_defer(void* object);
+
+// wait until all objects handed over before are deleted
+void Reclaimer_drain(void);
+#endif
\ No newline at end of file
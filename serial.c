@@ -0,0 +1,267 @@
+#include "serial.h"
+#include "RAII.h"
+#include "memory.h"
+#include <limits.h>
+#include <stdint.h>
+// [DESIGN: Serialized Container Format]
+//  a container is written as bits through BitIO, with no padding anywhere:
+//   1. Number of elements, in a varint
+//   2. Packing of each field, keys first then values if written: the width of codec in a varint, and if it is
+//    0, Serial_WidthBits bits telling how many bits each packed integer or length of that field takes
+//   3. Elements one after another, each with its key then its value. An integer takes as many bits as its
+//    field packs, an element of fixed width takes width bytes, and an element of varying length takes its
+//    length packed likewise followed by as many bytes
+//  elements are gathered into an array before writing, so that the packing of a field is known before any
+//   element is written, and read into an array before any is put into a container, so that a corrupted
+//   stream leaves the container as it was
+enum SerialIO_Constant{
+    SerialIO_ChunkBytes = 1 << 24,  // most bytes of an element read or written by a single call to BitIO
+};
+
+const SerialCodec SerialCodec_integer = {.width = 0, .bytes = NULL, .make = NULL, .owned = false};
+
+// buffer elements of varying length are read into
+typedef struct{
+    unsigned char* data;
+    size_t capability;
+}SerialBuffer_;
+
+// get number of bits value takes
+static unsigned int Serial_bits_(uint64_t value){
+    unsigned int bits = 0;
+    while(bits < 64 && (value >> bits) != 0) bits += 1;
+    return bits;
+}
+
+// get number of bits each packed integer or length of a field takes, 0 for elements of fixed width
+//  elements of the field are count pointers from elements
+static unsigned int Serial_packing_(const SerialCodec* codec, void** elements, size_t count){
+    if(codec->width != 0) return 0;
+    uint64_t greatest = 0;
+    for(size_t i = 0; i < count; i++){
+        uint64_t packed;
+        if(codec->bytes == NULL){
+            packed = (uintptr_t)elements[i];
+        }else{
+            const void* bytes;
+            packed = codec->bytes(elements[i], &bytes);
+        }
+        if(packed > greatest) greatest = packed;
+    }
+    return Serial_bits_(greatest);
+}
+
+// write bytes in chunks, since BitIO takes number of bits in an unsigned int
+static void Serial_write_bytes_(BitIO* io, const unsigned char* bytes, size_t length){
+    while(length != 0){
+        const size_t chunk = length < SerialIO_ChunkBytes ? length : SerialIO_ChunkBytes;
+        BitIO_write(io, bytes, chunk * CHAR_BIT);
+        bytes += chunk;
+        length -= chunk;
+    }
+}
+
+// read bytes in chunks, return if all of them are read
+static bool Serial_read_bytes_(BitIO* io, unsigned char* bytes, size_t length){
+    while(length != 0){
+        const size_t chunk = length < SerialIO_ChunkBytes ? length : SerialIO_ChunkBytes;
+        if(BitIO_read(io, bytes, chunk * CHAR_BIT) != chunk * CHAR_BIT) return false;
+        bytes += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+static void Serial_write_element_(BitIO* io, const SerialCodec* codec, unsigned int packing, void* element){
+    if(codec->bytes == NULL){
+        BitIO_write_uint(io, (uintptr_t)element, packing);
+        return;
+    }
+    const void* bytes;
+    const size_t length = codec->bytes(element, &bytes);
+    if(codec->width == 0) BitIO_write_uint(io, length, packing);
+    Serial_write_bytes_(io, (const unsigned char*)bytes, codec->width == 0 ? length : codec->width);
+}
+
+// read an element into element, return false if the stream ends early or is corrupted
+static bool Serial_read_element_(
+    BitIO* io, const SerialCodec* codec, unsigned int packing, SerialBuffer_* buffer, void** element
+){
+    uint64_t length = codec->width;
+    if(codec->width == 0){
+        if(!BitIO_read_uint(io, &length, packing)) return false;
+        if(codec->make == NULL){
+            *element = (void*)(uintptr_t)length;
+            return true;
+        }
+    }
+    if(length > buffer->capability){
+        // a corrupted length fails either to be allocated or to be read
+        if(length > SIZE_MAX / 2) return false;
+        unsigned char* data = (unsigned char*)Memory_reallocate(buffer->data, length);
+        if(data == NULL) return false;
+        buffer->data = data;
+        buffer->capability = length;
+    }
+    if(!Serial_read_bytes_(io, buffer->data, length)) return false;
+    *element = codec->make(buffer->data, length);
+    return true;
+}
+
+// write count elements, each having one field from each of fields arrays of count pointers stored one after
+//  another in elements
+static void Serial_write_(BitIO* io, void** elements, size_t count, const SerialCodec* const* codecs,
+                          unsigned int fields){
+    unsigned int packings[2];
+    BitIO_write_varint(io, count);
+    for(unsigned int field = 0; field < fields; field++){
+        BitIO_write_varint(io, codecs[field]->width);
+        packings[field] = Serial_packing_(codecs[field], elements + field * count, count);
+        if(codecs[field]->width == 0) BitIO_write_uint(io, packings[field], Serial_WidthBits);
+    }
+    for(size_t i = 0; i < count; i++){
+        for(unsigned int field = 0; field < fields; field++){
+            Serial_write_element_(io, codecs[field], packings[field], elements[field * count + i]);
+        }
+    }
+}
+
+// delete elements made so far that are owned, which are the first made of count elements in each field
+static void Serial_discard_(void** elements, size_t count, size_t made, const SerialCodec* const* codecs,
+                            unsigned int fields){
+    for(unsigned int field = 0; field < fields; field++){
+        if(!codecs[field]->owned || codecs[field]->make == NULL) continue;
+        const size_t field_made = made / fields + (field < made % fields);
+        for(size_t i = 0; i < field_made; i++) RAII_delete(elements[field * count + i]);
+    }
+}
+
+// read elements written by Serial_write_ into an array laid out in the same way, which count receives
+//  return the array, which shall be released by Memory_release, or NULL if the stream ends early or is
+//   corrupted, in which case elements made are deleted if owned
+static void** Serial_read_(BitIO* io, const SerialCodec* const* codecs, unsigned int fields, size_t* count){
+    uint64_t size;
+    unsigned int packings[2];
+    if(!BitIO_read_varint(io, &size)) return NULL;
+    for(unsigned int field = 0; field < fields; field++){
+        uint64_t width, packing = 0;
+        if(!BitIO_read_varint(io, &width) || width != codecs[field]->width) return NULL;
+        if(width == 0 && (!BitIO_read_uint(io, &packing, Serial_WidthBits) || packing > 64)) return NULL;
+        packings[field] = packing;
+    }
+    if(size > SIZE_MAX / sizeof(void*) / fields) return NULL;
+    void** elements = (void**)Memory_allocate(sizeof(void*) * fields * (size == 0 ? 1 : size));
+    if(elements == NULL) return NULL;
+    SerialBuffer_ buffer = {.data = NULL, .capability = 0};
+    size_t made = 0;
+    for(; made < size * fields; made++){
+        const unsigned int field = made % fields;
+        void** element = elements + field * size + made / fields;
+        if(!Serial_read_element_(io, codecs[field], packings[field], &buffer, element)) break;
+    }
+    Memory_release(buffer.data);
+    if(made != size * fields){
+        Serial_discard_(elements, size, made, codecs, fields);
+        Memory_release(elements);
+        return NULL;
+    }
+    *count = size;
+    return elements;
+}
+
+void Vector_serialize(Vector* vector, BitIO* io, const SerialCodec* codec){
+    const size_t size = Vector_size(vector);
+    void** elements = (void**)Memory_allocate(sizeof(void*) * (size == 0 ? 1 : size));
+    for(size_t i = 0; i < size; i++) elements[i] = Vector_at(vector, i);
+    Serial_write_(io, elements, size, &codec, 1);
+    Memory_release(elements);
+}
+
+bool Vector_deserialize(Vector* vector, BitIO* io, const SerialCodec* codec){
+    size_t count;
+    void** elements = Serial_read_(io, &codec, 1, &count);
+    if(elements == NULL) return false;
+    Vector_recap(vector, Vector_size(vector) + count);
+    for(size_t i = 0; i < count; i++) Vector_emplace_back(vector, elements[i], codec->owned);
+    Memory_release(elements);
+    return true;
+}
+
+// entries gathered from a container, laid out as Serial_write_ takes
+typedef struct{
+    void** elements;
+    size_t count;
+    size_t gathered;
+    bool values;
+}SerialEntries_;
+
+static void SerialEntries_gather_(KeyValue* entry, void* context){
+    SerialEntries_* entries = (SerialEntries_*)context;
+    entries->elements[entries->gathered] = entry->key;
+    if(entries->values) entries->elements[entries->count + entries->gathered] = entry->value;
+    entries->gathered += 1;
+}
+
+// allocate room for count entries to be gathered
+static void SerialEntries_initialize_(SerialEntries_* entries, size_t count, bool values){
+    entries->elements = (void**)Memory_allocate(sizeof(void*) * (values ? 2 : 1) * (count == 0 ? 1 : count));
+    entries->count = count;
+    entries->gathered = 0;
+    entries->values = values;
+}
+
+void Heap_serialize(Heap* heap, BitIO* io, const SerialCodec* keys, const SerialCodec* values){
+    const SerialCodec* codecs[] = {keys, values};
+    SerialEntries_ entries;
+    SerialEntries_initialize_(&entries, Heap_size(heap), values != NULL);
+    Heap_foreach(heap, SerialEntries_gather_, &entries);
+    Serial_write_(io, entries.elements, entries.count, codecs, values != NULL ? 2 : 1);
+    Memory_release(entries.elements);
+}
+
+bool Heap_deserialize(Heap* heap, BitIO* io, const SerialCodec* keys, const SerialCodec* values){
+    const SerialCodec* codecs[] = {keys, values};
+    const unsigned int fields = values != NULL ? 2 : 1;
+    size_t count;
+    void** elements = Serial_read_(io, codecs, fields, &count);
+    if(elements == NULL) return false;
+    if(count > UINT_MAX - Heap_size(heap)){
+        Serial_discard_(elements, count, count * fields, codecs, fields);
+        Memory_release(elements);
+        return false;
+    }
+    Heap_build(
+        heap, elements, keys->owned, values != NULL ? elements + count : NULL, values != NULL && values->owned,
+        count
+    );
+    Memory_release(elements);
+    return true;
+}
+
+void HashTable_serialize(HashTable* hash_table, BitIO* io, const SerialCodec* keys, const SerialCodec* values){
+    const SerialCodec* codecs[] = {keys, values};
+    SerialEntries_ entries;
+    SerialEntries_initialize_(&entries, hash_table->size, values != NULL);
+    HashTable_foreach(hash_table, SerialEntries_gather_, &entries);
+    Serial_write_(io, entries.elements, entries.count, codecs, values != NULL ? 2 : 1);
+    Memory_release(entries.elements);
+}
+
+bool HashTable_deserialize(
+    HashTable* hash_table, BitIO* io, const SerialCodec* keys, const SerialCodec* values
+){
+    const SerialCodec* codecs[] = {keys, values};
+    size_t count;
+    void** elements = Serial_read_(io, codecs, values != NULL ? 2 : 1, &count);
+    if(elements == NULL) return false;
+    HashTable_reserve(hash_table, hash_table->size + count);
+    // entries with same key were visited from the last inserted on, insert them the other way round
+    for(size_t i = count; i > 0; i--){
+        HashTable_insert_direct(
+            hash_table, elements[i - 1], keys->owned, values != NULL ? elements[count + i - 1] : NULL,
+            values != NULL && values->owned
+        );
+    }
+    Memory_release(elements);
+    return true;
+}
\ No newline at end of file
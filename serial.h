@@ -0,0 +1,61 @@
+#ifndef CxKANOAXDP_serial_H_
+#define CxKANOAXDP_serial_H_
+#include "bitio.h"
+#include "hashtable.h"
+#include "heap.h"
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+// serialization of containers into BitIO streams, and loading them back
+//  a container is written as the number of its elements in a varint, followed by how elements are packed,
+//   then the elements one by one, keys before values. Integers stored as pointers are bit-packed in as many
+//   bits as the greatest of them takes, and so are lengths of elements of varying length
+//  the stream carries no type information, it shall be read with the codecs it was written with
+//  loading reads all elements before putting any into the container, which is sized for them all at once,
+//   so that a vector or a heap grows its array, or a hash table its lines, by a single allocation
+enum Serial_Constant{
+    Serial_WidthBits = 7,   // bits telling how many bits each packed integer or length takes, up to 64
+};
+// how elements of a container are written and made again
+typedef struct{
+    // bytes of every element if elements are of fixed width, 0 if each is written after its length
+    size_t width;
+    // get the bytes representing an element and their number, in the same way as HashTableSnapshot_Serializer
+    //  bytes shall stay valid until the next call. NULL if elements are unsigned integers stored as pointers
+    size_t (*bytes)(const void* element, const void** bytes);
+    // make an element from bytes read, which are valid only during the call
+    //  NULL if elements are unsigned integers stored as pointers
+    void* (*make)(const void* bytes, size_t length);
+    // if elements made are owned by the container, in which case they must be RAII objects
+    bool owned;
+}SerialCodec;
+
+// codec of unsigned integers stored as pointers
+extern const SerialCodec SerialCodec_integer;
+
+// write elements of vector to io, which is opened for write
+void Vector_serialize(Vector* vector, BitIO* io, const SerialCodec* codec);
+
+// read elements written by Vector_serialize from io and append them to vector
+//  return false if the stream ends early or is corrupted, in which case vector is left as is
+bool Vector_deserialize(Vector* vector, BitIO* io, const SerialCodec* codec);
+
+// write entries of heap to io in the order they are laid out, values are not written if values is NULL
+void Heap_serialize(Heap* heap, BitIO* io, const SerialCodec* keys, const SerialCodec* values);
+
+// read entries written by Heap_serialize from io and insert them into heap, values are all NULL if values
+//  is NULL. Entries read into an empty heap are laid out as they were written
+//  return false if the stream ends early or is corrupted, in which case heap is left as is
+bool Heap_deserialize(Heap* heap, BitIO* io, const SerialCodec* keys, const SerialCodec* values);
+
+// write entries of hash table to io, values are not written if values is NULL
+void HashTable_serialize(HashTable* hash_table, BitIO* io, const SerialCodec* keys, const SerialCodec* values);
+
+// read entries written by HashTable_serialize from io and insert them into hash table, ignoring any key conflict
+//  values are all NULL if values is NULL. Among entries with same key, the one found before writing is still
+//   found after reading into an empty table
+//  return false if the stream ends early or is corrupted, in which case hash table is left as is
+bool HashTable_deserialize(
+    HashTable* hash_table, BitIO* io, const SerialCodec* keys, const SerialCodec* values
+);
+#endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "slab.h"
+#include "chunk.h"
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <threads.h>
+enum Slab_InternalConstant{
+    Slab_Classes = Slab_MaxSize / Slab_Granularity,     // number of sizes of slots
+    Slab_Batch = 32,                                    // slots in each batch moved between caches and pools
+};
+// free slot, linked through its own memory
+//  the first slot of a full batch in a pool also links the next batch
+typedef struct SlabSlot_{
+    struct SlabSlot_* next;
+    struct SlabSlot_* next_batch;
+}SlabSlot_;
+// shared pool of slots of one size, which is the owner of all chunks carved into such slots
+typedef struct{
+    alignas(64) ChunkOwner owner;
+    unsigned int size_class;
+    mtx_t lock;
+    // batches of exactly Slab_Batch slots, exchanged with caches as a whole
+    SlabSlot_* batches;
+    // slots returned by caches of exiting threads, which are gathered into batches when no batch is left
+    SlabSlot_* loose;
+    // part of the latest chunk not yet carved into slots
+    char* carve;
+    char* carve_end;
+}SlabPool_;
+// cache of slots of one size held by a thread
+//  slots are taken from and released to the current list. When the current list fills up, it becomes the
+//   spare one, and any spare list before is returned to pool, so that allocations and releases alternating
+//   around the boundary do not bounce batches to and from pool
+typedef struct{
+    SlabSlot_* current;
+    unsigned int count;
+    SlabSlot_* spare;
+}SlabCache_;
+static SlabPool_ Slab_pools_[Slab_Classes];
+static once_flag Slab_once_ = ONCE_FLAG_INIT;
+// key whose destructor returns caches of an exiting thread, set to the caches once they are in use
+static tss_t Slab_exit_key_;
+static _Thread_local SlabCache_ Slab_caches_[Slab_Classes];
+static _Thread_local bool Slab_registered_ = false;
+
+static void Slab_release_(ChunkOwner* owner, void* object);
+
+// get size of slots of a class
+static inline size_t Slab_class_size_(unsigned int size_class){
+    return (size_t)(size_class + 1) * Slab_Granularity;
+}
+
+// move all slots of a list into loose slots of pool, pool must be locked
+static void Slab_pool_loosen_(SlabPool_* pool, SlabSlot_* slots){
+    while(slots != NULL){
+        SlabSlot_* next = slots->next;
+        slots->next = pool->loose;
+        pool->loose = slots;
+        slots = next;
+    }
+}
+
+// return all slots in caches of calling thread to pools
+static void Slab_thread_exit_(void* caches_){
+    SlabCache_* caches = (SlabCache_*)caches_;
+    for(unsigned int i = 0; i < Slab_Classes; i++){
+        if(caches[i].current == NULL && caches[i].spare == NULL) continue;
+        mtx_lock(&Slab_pools_[i].lock);
+        Slab_pool_loosen_(Slab_pools_ + i, caches[i].current);
+        Slab_pool_loosen_(Slab_pools_ + i, caches[i].spare);
+        mtx_unlock(&Slab_pools_[i].lock);
+        caches[i] = (SlabCache_){0};
+    }
+}
+
+static void Slab_initialize_(void){
+    for(unsigned int i = 0; i < Slab_Classes; i++){
+        Slab_pools_[i].owner.release = Slab_release_;
+        Slab_pools_[i].owner.reallocate = NULL;
+        Slab_pools_[i].owner.allocator = NULL;
+        Slab_pools_[i].size_class = i;
+        mtx_init(&Slab_pools_[i].lock, mtx_plain);
+        Slab_pools_[i].batches = Slab_pools_[i].loose = NULL;
+        Slab_pools_[i].carve = Slab_pools_[i].carve_end = NULL;
+    }
+    tss_create(&Slab_exit_key_, Slab_thread_exit_);
+}
+
+// have caches of calling thread returned when it exits
+static inline void Slab_register_thread_(void){
+    if(Slab_registered_) return;
+    tss_set(Slab_exit_key_, Slab_caches_);
+    Slab_registered_ = true;
+}
+
+// take a batch of slots from pool, gathering loose slots or carving a new chunk if no batch is left
+//  return the list of slots taken, with their number in count
+static SlabSlot_* Slab_pool_take_(SlabPool_* pool, unsigned int* count){
+    SlabSlot_* batch = NULL;
+    *count = 0;
+    mtx_lock(&pool->lock);
+    if(pool->batches != NULL){
+        batch = pool->batches;
+        pool->batches = batch->next_batch;
+        *count = Slab_Batch;
+    }else{
+        const size_t size = Slab_class_size_(pool->size_class);
+        while(*count < Slab_Batch){
+            SlabSlot_* slot = pool->loose;
+            if(slot != NULL){
+                pool->loose = slot->next;
+            }else{
+                if(pool->carve == pool->carve_end){
+                    char* chunk = (char*)Chunk_allocate(&pool->owner, Chunk_Size);
+                    if(chunk == NULL) break;
+                    pool->carve = chunk;
+                    pool->carve_end = chunk + Chunk_Size / size * size;
+                }
+                slot = (SlabSlot_*)pool->carve;
+                pool->carve += size;
+            }
+            slot->next = batch;
+            batch = slot;
+            *count += 1;
+        }
+    }
+    mtx_unlock(&pool->lock);
+    return batch;
+}
+
+// put a full batch of slots into pool
+static void Slab_pool_put_(SlabPool_* pool, SlabSlot_* batch){
+    mtx_lock(&pool->lock);
+    batch->next_batch = pool->batches;
+    pool->batches = batch;
+    mtx_unlock(&pool->lock);
+}
+
+// release an object to cache of calling thread
+static void Slab_release_(ChunkOwner* owner, void* object){
+    const unsigned int size_class = ((SlabPool_*)owner)->size_class;
+    SlabCache_* cache = Slab_caches_ + size_class;
+    // threads releasing objects allocated by others hold slots in their caches too
+    Slab_register_thread_();
+    if(cache->count == Slab_Batch){
+        if(cache->spare != NULL) Slab_pool_put_(Slab_pools_ + size_class, cache->spare);
+        cache->spare = cache->current;
+        cache->current = NULL;
+        cache->count = 0;
+    }
+    SlabSlot_* slot = (SlabSlot_*)object;
+    slot->next = cache->current;
+    cache->current = slot;
+    cache->count += 1;
+}
+
+void* Slab_allocate(size_t size){
+    const unsigned int size_class = size == 0 ? 0 : (size - 1) / Slab_Granularity;
+    SlabCache_* cache = Slab_caches_ + size_class;
+    if(cache->current == NULL){
+        if(cache->spare != NULL){
+            cache->current = cache->spare;
+            cache->spare = NULL;
+            cache->count = Slab_Batch;
+        }else{
+            call_once(&Slab_once_, Slab_initialize_);
+            Slab_register_thread_();
+            cache->current = Slab_pool_take_(Slab_pools_ + size_class, &cache->count);
+            if(cache->current == NULL) return NULL;
+        }
+    }
+    SlabSlot_* slot = cache->current;
+    cache->current = slot->next;
+    cache->count -= 1;
+    return slot;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef CxKANOAXDP_slab_H_
+#define CxKANOAXDP_slab_H_
+#include <stddef.h>
+// allocator of small objects, carving chunks into slots of a few fixed sizes
+//  each thread keeps a cache of free slots of each size, which serves most allocations and releases
+//   without locking. Caches exchange slots with shared pools in batches, and are returned to the pools
+//   when their threads exit. Chunks are kept once allocated, since slots of a chunk may be scattered over
+//   caches of all threads
+enum Slab_Constant{
+    Slab_Granularity = 16,  // sizes of slots are multiples of this, which slots are also aligned to
+    Slab_MaxSize = 256,     // largest object served
+};
+
+// allocate memory for an object of no more than Slab_MaxSize bytes
+//  the object is released by Memory_release, which finds the slab through the chunk registry
+//  return NULL if out of memory
+void* Slab_allocate(size_t size);
+#endif
\ No newline at end of file
@@ -13,4 +13,10 @@
 #else
 #define NoDiscard
 #endif
+// hint that the memory at address will be read soon, so that the cache miss overlaps with other work
+#if defined(__GNUC__)
+#define Prefetch(address) __builtin_prefetch(address)
+#else
+#define Prefetch(address) ((void)(address))
+#endif
 #endif
\ No newline at end of file
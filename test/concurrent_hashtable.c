@@ -0,0 +1,135 @@
+#include "concurrent_hashtable.h"
+#include "RAII.h"
+#include "memory.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <threads.h>
+// threads insert, erase and look up keys of their own while reading keys of the others, on a table created
+//  with few lines so that it grows many times meanwhile
+//  values are RAII objects recording their key, a value read after being reclaimed is caught by the check of
+//   its key, or by address sanitizer, and the count of deleted values tells if any was leaked or deleted twice
+enum TestConcurrentHashTable_Constant{
+    TestConcurrentHashTable_Threads = 8,
+    TestConcurrentHashTable_Keys = 20000,   // keys of each thread
+    TestConcurrentHashTable_Rounds = 3,
+};
+#define TestConcurrentHashTable_check(condition) do{ \
+    if(!(condition)){ \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        exit(EXIT_FAILURE); \
+    } \
+}while(0)
+typedef struct{
+    RAII _;
+    uintptr_t key;
+}TestValue;
+static ConcurrentHashTable* TestConcurrentHashTable_table_;
+static atomic_size_t TestConcurrentHashTable_created_;
+static atomic_size_t TestConcurrentHashTable_deleted_;
+
+static unsigned int TestConcurrentHashTable_hash_(const void* key){
+    uint64_t value = (uintptr_t)key * UINT64_C(0x9E3779B97F4A7C15);
+    return (unsigned int)(value >> 32);
+}
+
+static int TestConcurrentHashTable_compare_(const void* lhs_, const void* rhs_){
+    return lhs_ != rhs_;
+}
+
+static void TestValue_deleter_(void* target_){
+    (void)target_;
+    atomic_fetch_add(&TestConcurrentHashTable_deleted_, 1);
+}
+
+static TestValue* TestValue_create_(uintptr_t key){
+    TestValue* value = (TestValue*)Memory_allocate_object(sizeof(TestValue));
+    value->key = key;
+    RAII_set_deleter(value, TestValue_deleter_);
+    atomic_fetch_add(&TestConcurrentHashTable_created_, 1);
+    return value;
+}
+
+// key i of thread, never 0
+static uintptr_t TestConcurrentHashTable_key_(unsigned int thread, size_t i){
+    return (uintptr_t)thread * TestConcurrentHashTable_Keys + i + 1;
+}
+
+// look up a key of any thread, whose value must be intact while in the critical section
+static void TestConcurrentHashTable_peek_(uint64_t* random){
+    *random = *random * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+    const uintptr_t key = TestConcurrentHashTable_key_(
+        (unsigned int)(*random >> 60) % TestConcurrentHashTable_Threads,
+        (size_t)(*random >> 20) % TestConcurrentHashTable_Keys
+    );
+    const unsigned int token = ConcurrentHashTable_read_lock(TestConcurrentHashTable_table_);
+    KeyValue* entry = ConcurrentHashTable_find(TestConcurrentHashTable_table_, (void*)key);
+    if(entry != NULL){
+        TestConcurrentHashTable_check((uintptr_t)entry->key == key);
+        TestConcurrentHashTable_check(((TestValue*)entry->value)->key == key);
+    }
+    ConcurrentHashTable_read_unlock(TestConcurrentHashTable_table_, token);
+}
+
+static int TestConcurrentHashTable_work_(void* argument){
+    const unsigned int thread = (unsigned int)(uintptr_t)argument;
+    ConcurrentHashTable* table = TestConcurrentHashTable_table_;
+    uint64_t random = thread + 1;
+    for(unsigned int round = 0; round < TestConcurrentHashTable_Rounds; round++){
+        for(size_t i = 0; i < TestConcurrentHashTable_Keys; i++){
+            const uintptr_t key = TestConcurrentHashTable_key_(thread, i);
+            TestValue* value = TestValue_create_(key);
+            KeyValue* entry;
+            TestConcurrentHashTable_check(
+                ConcurrentHashTable_insert(table, (void*)key, false, value, true, &entry)
+            );
+            TestConcurrentHashTable_check(entry->value == value);
+            // inserting again keeps the entry, leaving the value to the caller
+            TestValue* duplicate = TestValue_create_(key);
+            TestConcurrentHashTable_check(
+                !ConcurrentHashTable_insert(table, (void*)key, false, duplicate, true, NULL)
+            );
+            RAII_delete(duplicate);
+            TestConcurrentHashTable_peek_(&random);
+        }
+        for(size_t i = 0; i < TestConcurrentHashTable_Keys; i++){
+            const uintptr_t key = TestConcurrentHashTable_key_(thread, i);
+            KeyValue* entry = ConcurrentHashTable_find(table, (void*)key);
+            TestConcurrentHashTable_check(entry != NULL && ((TestValue*)entry->value)->key == key);
+        }
+        // erase odd keys, and all of them in the last round
+        for(size_t i = 0; i < TestConcurrentHashTable_Keys; i++){
+            const uintptr_t key = TestConcurrentHashTable_key_(thread, i);
+            const bool erase = i % 2 == 1 || round + 1 == TestConcurrentHashTable_Rounds;
+            if(erase) TestConcurrentHashTable_check(ConcurrentHashTable_erase(table, (void*)key));
+            TestConcurrentHashTable_peek_(&random);
+        }
+        for(size_t i = 0; i < TestConcurrentHashTable_Keys; i++){
+            const uintptr_t key = TestConcurrentHashTable_key_(thread, i);
+            const bool kept = i % 2 == 0 && round + 1 != TestConcurrentHashTable_Rounds;
+            TestConcurrentHashTable_check((ConcurrentHashTable_find(table, (void*)key) != NULL) == kept);
+            if(kept) TestConcurrentHashTable_check(ConcurrentHashTable_erase(table, (void*)key));
+        }
+    }
+    return 0;
+}
+
+int main(void){
+    TestConcurrentHashTable_table_ = ConcurrentHashTable_create(
+        1, TestConcurrentHashTable_hash_, TestConcurrentHashTable_compare_
+    );
+    thrd_t threads[TestConcurrentHashTable_Threads];
+    for(unsigned int i = 0; i < TestConcurrentHashTable_Threads; i++){
+        TestConcurrentHashTable_check(
+            thrd_create(threads + i, TestConcurrentHashTable_work_, (void*)(uintptr_t)i) == thrd_success
+        );
+    }
+    for(unsigned int i = 0; i < TestConcurrentHashTable_Threads; i++) thrd_join(threads[i], NULL);
+    TestConcurrentHashTable_check(ConcurrentHashTable_size(TestConcurrentHashTable_table_) == 0);
+    RAII_delete(TestConcurrentHashTable_table_);
+    TestConcurrentHashTable_check(
+        atomic_load(&TestConcurrentHashTable_deleted_) == atomic_load(&TestConcurrentHashTable_created_)
+    );
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
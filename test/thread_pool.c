@@ -0,0 +1,109 @@
+#include "thread_pool.h"
+#include "RAII.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+// exercises work stealing, parking of idle workers and the handoff of finished task groups with
+//  1. parallel_for nested in the body of another parallel_for
+//  2. tasks waiting for task groups of their own, recursively
+//  3. a pool deleted with tasks still queued, which must run all of them
+//  all are run on pools of several sizes, with and without spinning before parking. Thread sanitizer cannot
+//   check this test, since glibc creates threads for thrd_create without going through its interceptor, so
+//   it is run under address sanitizer instead
+enum TestThreadPool_Constant{
+    TestThreadPool_Outer = 64,          // indexes of the outer parallel_for
+    TestThreadPool_Inner = 1000,        // indexes of each inner parallel_for
+    TestThreadPool_Depth = 16,          // argument of the recursive task, which makes fib(17) leaves
+    TestThreadPool_Queued = 20000,      // tasks queued before the pool is deleted
+};
+#define TestThreadPool_check(condition) do{ \
+    if(!(condition)){ \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        exit(EXIT_FAILURE); \
+    } \
+}while(0)
+static ThreadPool* TestThreadPool_pool_;
+static atomic_size_t TestThreadPool_sum_;
+
+static void TestThreadPool_inner_(size_t begin, size_t end, void* context){
+    const size_t outer = (size_t)(uintptr_t)context;
+    size_t sum = 0;
+    for(size_t i = begin; i < end; i++) sum += outer * TestThreadPool_Inner + i;
+    atomic_fetch_add(&TestThreadPool_sum_, sum);
+}
+
+static void TestThreadPool_outer_(size_t begin, size_t end, void* context){
+    (void)context;
+    for(size_t i = begin; i < end; i++){
+        ThreadPool_parallel_for(TestThreadPool_pool_, 0, TestThreadPool_Inner, 7, TestThreadPool_inner_,
+                                (void*)(uintptr_t)i);
+    }
+}
+
+// argument of recursive task, which counts leaves of the tree of calls of fib
+typedef struct{
+    unsigned int n;
+    size_t leaves;
+}TestThreadPoolFib;
+
+static void TestThreadPool_fib_(void* argument){
+    TestThreadPoolFib* fib = (TestThreadPoolFib*)argument;
+    if(fib->n < 2){
+        fib->leaves = 1;
+        return;
+    }
+    TestThreadPoolFib children[2] = {{.n = fib->n - 1, .leaves = 0}, {.n = fib->n - 2, .leaves = 0}};
+    TaskGroup* group = TaskGroup_create(TestThreadPool_pool_);
+    TaskGroup_submit(group, TestThreadPool_fib_, children);
+    TaskGroup_submit(group, TestThreadPool_fib_, children + 1);
+    TaskGroup_wait(group);
+    RAII_delete(group);
+    fib->leaves = children[0].leaves + children[1].leaves;
+}
+
+static void TestThreadPool_increment_(void* argument){
+    atomic_fetch_add((atomic_size_t*)argument, 1);
+}
+
+// submit tasks from within a task, which go to the deque of the worker rather than the shared queue
+static void TestThreadPool_spawn_(void* argument){
+    for(unsigned int i = 0; i < 100; i++){
+        ThreadPool_submit(TestThreadPool_pool_, TestThreadPool_increment_, argument);
+    }
+}
+
+static void TestThreadPool_run_(const ThreadPoolOptions* options){
+    TestThreadPool_pool_ = ThreadPool_create(options);
+    TestThreadPool_check(TestThreadPool_pool_ != NULL);
+    // nested parallel_for
+    atomic_store(&TestThreadPool_sum_, 0);
+    ThreadPool_parallel_for(TestThreadPool_pool_, 0, TestThreadPool_Outer, 1, TestThreadPool_outer_, NULL);
+    const size_t indexes = (size_t)TestThreadPool_Outer * TestThreadPool_Inner;
+    TestThreadPool_check(atomic_load(&TestThreadPool_sum_) == indexes * (indexes - 1) / 2);
+    // task groups waited for inside tasks
+    TestThreadPoolFib fib = {.n = TestThreadPool_Depth, .leaves = 0};
+    ThreadPool_submit(TestThreadPool_pool_, TestThreadPool_fib_, &fib);
+    ThreadPool_wait(TestThreadPool_pool_);
+    TestThreadPool_check(fib.leaves == 1597);
+    // deleting the pool with tasks queued both in the shared queue and in deques of workers
+    atomic_size_t done = 0;
+    for(unsigned int i = 0; i < TestThreadPool_Queued; i++){
+        if(i % 100 == 0) ThreadPool_submit(TestThreadPool_pool_, TestThreadPool_spawn_, &done);
+        else ThreadPool_submit(TestThreadPool_pool_, TestThreadPool_increment_, &done);
+    }
+    RAII_delete(TestThreadPool_pool_);
+    TestThreadPool_check(atomic_load(&done) == TestThreadPool_Queued / 100 * 99 + TestThreadPool_Queued);
+}
+
+int main(void){
+    const unsigned int workers[] = {1, 2, 4, 8, 0};
+    for(unsigned int i = 0; i < sizeof(workers) / sizeof(*workers); i++){
+        ThreadPoolOptions options = {.workers = workers[i], .affinity = ThreadPoolAffinity_None, .spins = 0};
+        TestThreadPool_run_(&options);
+        // park at once, so that waking parked workers is exercised as much as possible
+        options.spins = 1;
+        TestThreadPool_run_(&options);
+    }
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
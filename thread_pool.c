@@ -0,0 +1,519 @@
+#if defined(__linux__)
+#define _GNU_SOURCE
+#include <sched.h>
+#endif
+#include "thread_pool.h"
+#include "RAII.h"
+#include "arena.h"
+#include "memory.h"
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <threads.h>
+#include <time.h>
+#include <unistd.h>
+// [DESIGN: Work Stealing]
+//  deques of workers are those of Chase and Lev, in the C11 formulation of Le et al.: the owner pushes and
+//   takes at the bottom without locking, thieves take from the top with a compare and swap, and the owner
+//   races thieves with the same compare and swap only for the last task. Rings of deques grow by doubling,
+//   and rings replaced are kept until the pool is deleted since thieves may still be reading them
+//  a worker looks for tasks in its own deque, then in the shared queue, then in deques of others starting
+//   from a random one. Threads waiting for groups look for tasks in the same way
+//  parking is guarded in the way of Dekker: a worker counts itself as sleeping and then looks for tasks
+//   once more under the pool lock before waiting, while a submitter puts its task and then checks the count
+//   of sleepers, so that either the worker sees the task or the submitter sees the worker and wakes it
+enum ThreadPoolDeque_Constant{
+    ThreadPoolDeque_CacheLine = 64,             // size of cache line, used to keep ends of deques apart
+    ThreadPoolDeque_InitialCapacity = 256,      // tasks a deque holds before growing, a power of 2
+    ThreadPoolDeque_WaitNanoseconds = 1000000,  // longest a thread waiting for a group sleeps before looking
+                                                //  for tasks again
+};
+typedef struct ThreadPoolTask_{
+    void (*function)(void* argument);
+    void* argument;
+    TaskGroup* group;
+    // next task in the shared queue
+    struct ThreadPoolTask_* next;
+}ThreadPoolTask_;
+// array of slots of a deque, indexed by positions modulo capacity
+typedef struct ThreadPoolRing_{
+    long long capacity;
+    // ring this one replaced when growing
+    struct ThreadPoolRing_* previous;
+    _Atomic(ThreadPoolTask_*) slots[];
+}ThreadPoolRing_;
+// a worker along with its deque, whose ends are kept on cache lines of their own
+typedef struct{
+    alignas(ThreadPoolDeque_CacheLine) atomic_llong top;
+    alignas(ThreadPoolDeque_CacheLine) atomic_llong bottom;
+    _Atomic(ThreadPoolRing_*) ring;
+    ThreadPool* pool;
+    thrd_t thread;
+    unsigned int index;
+}ThreadPoolWorker_;
+struct TaskGroup{
+    RAII _;
+    ThreadPool* pool;
+    // tasks submitted but not done yet
+    atomic_size_t pending;
+    // the last pending task is done under lock, so that waiters may sleep on done without missing it
+    mtx_t lock;
+    cnd_t done;
+};
+struct ThreadPool{
+    RAII _;
+    ThreadPoolWorker_* workers_;
+    unsigned int worker_count_;
+    // workers whose threads are started
+    unsigned int started_;
+    unsigned int spins_;
+    enum ThreadPoolAffinity affinity_;
+    // protects the shared queue, and parking of workers
+    mtx_t lock_;
+    cnd_t wake_;
+    // tasks submitted from outside the pool, oldest at head
+    ThreadPoolTask_* head_;
+    ThreadPoolTask_* tail_;
+    // number of tasks in the shared queue, which may be read without lock to skip locking when empty
+    atomic_size_t queued_;
+    atomic_uint sleepers_;
+    atomic_bool stopping_;
+    TaskGroup group_;
+};
+// worker the calling thread is, NULL if it is not a worker of any pool
+static _Thread_local ThreadPoolWorker_* ThreadPool_worker_ = NULL;
+
+// allocate memory shared among threads, which must not come from an arena the calling thread is in
+static void* ThreadPool_allocate_(size_t size){
+    Arena* previous = Arena_enter(NULL);
+    void* block = Memory_allocate_object(size);
+    Arena_leave(previous);
+    return block;
+}
+
+// pick a random number, using a generator local to the calling thread
+static uint32_t ThreadPool_random_(void){
+    static _Thread_local uint32_t state = 0;
+    if(state == 0){
+        // seed with the address of the state which differs among threads
+        state = (uint32_t)(((uintptr_t)&state * 0x9E3779B97F4A7C15ull) >> 32) | 1u;
+    }
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static ThreadPoolRing_* ThreadPoolRing_create_(long long capacity){
+    Arena* previous = Arena_enter(NULL);
+    ThreadPoolRing_* ring = (ThreadPoolRing_*)Memory_allocate(
+        sizeof(ThreadPoolRing_) + sizeof(_Atomic(ThreadPoolTask_*)) * capacity
+    );
+    Arena_leave(previous);
+    ring->capacity = capacity;
+    ring->previous = NULL;
+    return ring;
+}
+
+// push a task at the bottom of deque of worker, called by the worker only
+static void ThreadPoolWorker_push_(ThreadPoolWorker_* worker, ThreadPoolTask_* task){
+    const long long bottom = atomic_load_explicit(&worker->bottom, memory_order_relaxed);
+    const long long top = atomic_load_explicit(&worker->top, memory_order_acquire);
+    ThreadPoolRing_* ring = atomic_load_explicit(&worker->ring, memory_order_relaxed);
+    if(bottom - top >= ring->capacity){
+        ThreadPoolRing_* grown = ThreadPoolRing_create_(ring->capacity << 1);
+        for(long long i = top; i < bottom; i++){
+            ThreadPoolTask_* moved = atomic_load_explicit(
+                &ring->slots[i & (ring->capacity - 1)], memory_order_relaxed
+            );
+            atomic_store_explicit(&grown->slots[i & (grown->capacity - 1)], moved, memory_order_relaxed);
+        }
+        grown->previous = ring;
+        atomic_store_explicit(&worker->ring, grown, memory_order_release);
+        ring = grown;
+    }
+    atomic_store_explicit(&ring->slots[bottom & (ring->capacity - 1)], task, memory_order_relaxed);
+    atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_release);
+}
+
+// take the task at the bottom of deque of worker, called by the worker only, return NULL if empty
+static ThreadPoolTask_* ThreadPoolWorker_take_(ThreadPoolWorker_* worker){
+    const long long bottom = atomic_load_explicit(&worker->bottom, memory_order_relaxed) - 1;
+    ThreadPoolRing_* ring = atomic_load_explicit(&worker->ring, memory_order_relaxed);
+    atomic_store_explicit(&worker->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long top = atomic_load_explicit(&worker->top, memory_order_relaxed);
+    if(top > bottom){
+        atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+    ThreadPoolTask_* task = atomic_load_explicit(&ring->slots[bottom & (ring->capacity - 1)], memory_order_relaxed);
+    if(top == bottom){
+        // the last task, which thieves may be racing for
+        if(!atomic_compare_exchange_strong_explicit(
+            &worker->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed
+        )) task = NULL;
+        atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+// steal the task at the top of deque of victim, return NULL if empty or lost to another thief, in which
+//  case contended is set
+static ThreadPoolTask_* ThreadPoolWorker_steal_(ThreadPoolWorker_* victim, bool* contended){
+    long long top = atomic_load_explicit(&victim->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    const long long bottom = atomic_load_explicit(&victim->bottom, memory_order_acquire);
+    if(top >= bottom) return NULL;
+    ThreadPoolRing_* ring = atomic_load_explicit(&victim->ring, memory_order_acquire);
+    ThreadPoolTask_* task = atomic_load_explicit(&ring->slots[top & (ring->capacity - 1)], memory_order_relaxed);
+    if(!atomic_compare_exchange_strong_explicit(
+        &victim->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed
+    )){
+        *contended = true;
+        return NULL;
+    }
+    return task;
+}
+
+// take the oldest task in the shared queue, return NULL if empty
+static ThreadPoolTask_* ThreadPool_dequeue_(ThreadPool* pool){
+    if(atomic_load_explicit(&pool->queued_, memory_order_relaxed) == 0) return NULL;
+    mtx_lock(&pool->lock_);
+    ThreadPoolTask_* task = pool->head_;
+    if(task != NULL){
+        pool->head_ = task->next;
+        if(pool->head_ == NULL) pool->tail_ = NULL;
+        atomic_fetch_sub_explicit(&pool->queued_, 1, memory_order_relaxed);
+    }
+    mtx_unlock(&pool->lock_);
+    return task;
+}
+
+// look for a task to run, worker is the calling thread or NULL if it is not a worker of pool
+//  return NULL if no task is found anywhere
+static ThreadPoolTask_* ThreadPool_find_(ThreadPool* pool, ThreadPoolWorker_* worker){
+    ThreadPoolTask_* task;
+    if(worker != NULL && (task = ThreadPoolWorker_take_(worker)) != NULL) return task;
+    if((task = ThreadPool_dequeue_(pool)) != NULL) return task;
+    bool contended;
+    do{
+        contended = false;
+        const unsigned int first = ThreadPool_random_() % pool->worker_count_;
+        for(unsigned int i = 0; i < pool->worker_count_; i++){
+            ThreadPoolWorker_* victim = pool->workers_ + (first + i) % pool->worker_count_;
+            if(victim == worker) continue;
+            if((task = ThreadPoolWorker_steal_(victim, &contended)) != NULL) return task;
+        }
+    }while(contended);
+    return NULL;
+}
+
+// check if there is any task to run, called under the pool lock
+static bool ThreadPool_has_task_(ThreadPool* pool){
+    if(pool->head_ != NULL) return true;
+    for(unsigned int i = 0; i < pool->worker_count_; i++){
+        ThreadPoolWorker_* worker = pool->workers_ + i;
+        if(atomic_load(&worker->bottom) > atomic_load(&worker->top)) return true;
+    }
+    return false;
+}
+
+// mark a task of group done
+static void TaskGroup_finish_(TaskGroup* group){
+    size_t pending = atomic_load_explicit(&group->pending, memory_order_relaxed);
+    while(pending > 1){
+        if(atomic_compare_exchange_weak_explicit(
+            &group->pending, &pending, pending - 1, memory_order_acq_rel, memory_order_relaxed
+        )) return;
+    }
+    // the group may be deleted once its waiters see no pending task, nothing is touched after unlocking
+    mtx_lock(&group->lock);
+    atomic_fetch_sub_explicit(&group->pending, 1, memory_order_acq_rel);
+    cnd_broadcast(&group->done);
+    mtx_unlock(&group->lock);
+}
+
+static void ThreadPool_run_(ThreadPoolTask_* task){
+    TaskGroup* group = task->group;
+    task->function(task->argument);
+    Memory_release(task);
+    TaskGroup_finish_(group);
+}
+
+// pin the calling worker to a processor as requested by affinity of pool
+static void ThreadPool_pin_(ThreadPoolWorker_* worker){
+    #if defined(__linux__)
+    if(worker->pool->affinity_ != ThreadPoolAffinity_Compact) return;
+    cpu_set_t allowed;
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    const int count = CPU_COUNT(&allowed);
+    if(count == 0) return;
+    int target = worker->index % count;
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+        if(!CPU_ISSET(cpu, &allowed) || target-- != 0) continue;
+        cpu_set_t pinned;
+        CPU_ZERO(&pinned);
+        CPU_SET(cpu, &pinned);
+        sched_setaffinity(0, sizeof(pinned), &pinned);
+        return;
+    }
+    #else
+    (void)worker;
+    #endif
+}
+
+// run tasks until the pool is deleted and no task is left
+static int ThreadPool_work_(void* argument){
+    ThreadPoolWorker_* worker = (ThreadPoolWorker_*)argument;
+    ThreadPool* pool = worker->pool;
+    ThreadPool_worker_ = worker;
+    ThreadPool_pin_(worker);
+    unsigned int idle = 0;
+    while(true){
+        ThreadPoolTask_* task = ThreadPool_find_(pool, worker);
+        if(task != NULL){
+            ThreadPool_run_(task);
+            idle = 0;
+            continue;
+        }
+        if(++idle < pool->spins_){
+            thrd_yield();
+            continue;
+        }
+        idle = 0;
+        mtx_lock(&pool->lock_);
+        atomic_fetch_add(&pool->sleepers_, 1);
+        while(!ThreadPool_has_task_(pool)){
+            if(atomic_load(&pool->stopping_)){
+                atomic_fetch_sub(&pool->sleepers_, 1);
+                mtx_unlock(&pool->lock_);
+                return 0;
+            }
+            cnd_wait(&pool->wake_, &pool->lock_);
+        }
+        atomic_fetch_sub(&pool->sleepers_, 1);
+        mtx_unlock(&pool->lock_);
+    }
+}
+
+static void ThreadPool_submit_(
+    ThreadPool* pool, TaskGroup* group, void (*function)(void* argument), void* argument
+){
+    ThreadPoolTask_* task = (ThreadPoolTask_*)ThreadPool_allocate_(sizeof(ThreadPoolTask_));
+    task->function = function;
+    task->argument = argument;
+    task->group = group;
+    task->next = NULL;
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+    ThreadPoolWorker_* worker = ThreadPool_worker_;
+    if(worker != NULL && worker->pool == pool){
+        ThreadPoolWorker_push_(worker, task);
+        atomic_thread_fence(memory_order_seq_cst);
+        if(atomic_load_explicit(&pool->sleepers_, memory_order_relaxed) == 0) return;
+        mtx_lock(&pool->lock_);
+        cnd_signal(&pool->wake_);
+        mtx_unlock(&pool->lock_);
+        return;
+    }
+    mtx_lock(&pool->lock_);
+    if(pool->tail_ != NULL){
+        pool->tail_->next = task;
+    }else{
+        pool->head_ = task;
+    }
+    pool->tail_ = task;
+    atomic_fetch_add_explicit(&pool->queued_, 1, memory_order_relaxed);
+    if(atomic_load(&pool->sleepers_) != 0) cnd_signal(&pool->wake_);
+    mtx_unlock(&pool->lock_);
+}
+
+static void TaskGroup_destroy_(void* target_){
+    TaskGroup* group = (TaskGroup*)target_;
+    TaskGroup_wait(group);
+    mtx_destroy(&group->lock);
+    cnd_destroy(&group->done);
+}
+
+static void TaskGroup_initialize_(TaskGroup* group, ThreadPool* pool){
+    group->pool = pool;
+    atomic_init(&group->pending, 0);
+    mtx_init(&group->lock, mtx_plain);
+    cnd_init(&group->done);
+    RAII_set_deleter(group, TaskGroup_destroy_);
+}
+
+static void ThreadPool_destroy_(void* target_){
+    ThreadPool* pool = (ThreadPool*)target_;
+    mtx_lock(&pool->lock_);
+    atomic_store(&pool->stopping_, true);
+    cnd_broadcast(&pool->wake_);
+    mtx_unlock(&pool->lock_);
+    for(unsigned int i = 0; i < pool->started_; i++) thrd_join(pool->workers_[i].thread, NULL);
+    for(unsigned int i = 0; i < pool->worker_count_; i++){
+        ThreadPoolRing_* ring = atomic_load_explicit(&pool->workers_[i].ring, memory_order_relaxed);
+        while(ring != NULL){
+            ThreadPoolRing_* previous = ring->previous;
+            Memory_release(ring);
+            ring = previous;
+        }
+    }
+    RAII_destroy(&pool->group_);
+    Memory_release(pool->workers_);
+    mtx_destroy(&pool->lock_);
+    cnd_destroy(&pool->wake_);
+}
+
+ThreadPool* ThreadPool_create(const ThreadPoolOptions* options){
+    static const ThreadPoolOptions defaults = {.workers = 0, .affinity = ThreadPoolAffinity_None, .spins = 0};
+    if(options == NULL) options = &defaults;
+    unsigned int workers = options->workers;
+    if(workers == 0){
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = processors > 0 ? processors : 1;
+    }
+    ThreadPool* pool = (ThreadPool*)ThreadPool_allocate_(sizeof(ThreadPool));
+    pool->workers_ = (ThreadPoolWorker_*)Memory_allocate_aligned(
+        sizeof(ThreadPoolWorker_) * workers, alignof(ThreadPoolWorker_)
+    );
+    pool->worker_count_ = workers;
+    pool->started_ = 0;
+    pool->spins_ = options->spins == 0 ? ThreadPool_Spins : options->spins;
+    pool->affinity_ = options->affinity;
+    mtx_init(&pool->lock_, mtx_plain);
+    cnd_init(&pool->wake_);
+    pool->head_ = pool->tail_ = NULL;
+    atomic_init(&pool->queued_, 0);
+    atomic_init(&pool->sleepers_, 0);
+    atomic_init(&pool->stopping_, false);
+    TaskGroup_initialize_(&pool->group_, pool);
+    for(unsigned int i = 0; i < workers; i++){
+        ThreadPoolWorker_* worker = pool->workers_ + i;
+        atomic_init(&worker->top, 0);
+        atomic_init(&worker->bottom, 0);
+        atomic_init(&worker->ring, ThreadPoolRing_create_(ThreadPoolDeque_InitialCapacity));
+        worker->pool = pool;
+        worker->index = i;
+    }
+    RAII_set_deleter(pool, ThreadPool_destroy_);
+    // deques of workers failing to start stay empty, as only their owners push
+    for(unsigned int i = 0; i < workers; i++){
+        if(thrd_create(&pool->workers_[i].thread, ThreadPool_work_, pool->workers_ + i) != thrd_success) break;
+        pool->started_ += 1;
+    }
+    if(pool->started_ == 0){
+        RAII_delete(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+unsigned int ThreadPool_workers(ThreadPool* pool){
+    return pool->started_;
+}
+
+void ThreadPool_submit(ThreadPool* pool, void (*function)(void* argument), void* argument){
+    ThreadPool_submit_(pool, &pool->group_, function, argument);
+}
+
+void ThreadPool_wait(ThreadPool* pool){
+    TaskGroup_wait(&pool->group_);
+}
+
+TaskGroup* TaskGroup_create(ThreadPool* pool){
+    TaskGroup* group = (TaskGroup*)ThreadPool_allocate_(sizeof(TaskGroup));
+    TaskGroup_initialize_(group, pool);
+    return group;
+}
+
+void TaskGroup_submit(TaskGroup* group, void (*function)(void* argument), void* argument){
+    ThreadPool_submit_(group->pool, group, function, argument);
+}
+
+void TaskGroup_wait(TaskGroup* group){
+    ThreadPool* pool = group->pool;
+    ThreadPoolWorker_* worker = ThreadPool_worker_;
+    if(worker != NULL && worker->pool != pool) worker = NULL;
+    unsigned int idle = 0;
+    while(atomic_load_explicit(&group->pending, memory_order_acquire) != 0){
+        ThreadPoolTask_* task = ThreadPool_find_(pool, worker);
+        if(task != NULL){
+            ThreadPool_run_(task);
+            idle = 0;
+            continue;
+        }
+        if(++idle < pool->spins_){
+            thrd_yield();
+            continue;
+        }
+        idle = 0;
+        // sleep until the group is done, or for a while before looking for tasks again, since tasks of the
+        //  group may be queued where no one else is looking, e.g. deques of workers which are waiting too
+        struct timespec deadline;
+        timespec_get(&deadline, TIME_UTC);
+        deadline.tv_nsec += ThreadPoolDeque_WaitNanoseconds;
+        if(deadline.tv_nsec >= 1000000000){
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+        mtx_lock(&group->lock);
+        if(atomic_load_explicit(&group->pending, memory_order_acquire) != 0){
+            cnd_timedwait(&group->done, &group->lock, &deadline);
+        }
+        mtx_unlock(&group->lock);
+    }
+    // the last task may still be waking waiters, wait until it is through with the group
+    mtx_lock(&group->lock);
+    mtx_unlock(&group->lock);
+}
+
+// range of parallel_for, split in halves until it is no longer than grain
+typedef struct{
+    void (*body)(size_t begin, size_t end, void* context);
+    void* context;
+    TaskGroup* group;
+    size_t begin;
+    size_t end;
+    size_t grain;
+}ThreadPoolRange_;
+
+static void ThreadPoolRange_task_(void* argument);
+
+// run a range, submitting upper halves as tasks of their own so that they may be stolen
+static void ThreadPoolRange_run_(ThreadPoolRange_* range){
+    size_t end = range->end;
+    while(end - range->begin > range->grain){
+        const size_t middle = range->begin + (end - range->begin) / 2;
+        ThreadPoolRange_* upper = (ThreadPoolRange_*)ThreadPool_allocate_(sizeof(ThreadPoolRange_));
+        *upper = *range;
+        upper->begin = middle;
+        upper->end = end;
+        TaskGroup_submit(range->group, ThreadPoolRange_task_, upper);
+        end = middle;
+    }
+    range->body(range->begin, end, range->context);
+}
+
+static void ThreadPoolRange_task_(void* argument){
+    ThreadPoolRange_run_((ThreadPoolRange_*)argument);
+    Memory_release(argument);
+}
+
+void ThreadPool_parallel_for(
+    ThreadPool* pool, size_t first, size_t last, size_t grain,
+    void (*body)(size_t begin, size_t end, void* context), void* context
+){
+    if(first >= last) return;
+    if(grain == 0){
+        grain = (last - first) / ((size_t)pool->started_ * ThreadPool_GrainDivisor);
+        if(grain == 0) grain = 1;
+    }
+    TaskGroup group;
+    TaskGroup_initialize_(&group, pool);
+    ThreadPoolRange_ range = {
+        .body = body, .context = context, .group = &group, .begin = first, .end = last, .grain = grain
+    };
+    ThreadPoolRange_run_(&range);
+    RAII_destroy(&group);
+}
\ No newline at end of file
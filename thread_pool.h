@@ -0,0 +1,68 @@
+#ifndef CxKANOAXDP_thread_pool_H_
+#define CxKANOAXDP_thread_pool_H_
+#include <stddef.h>
+// pool of worker threads running tasks, with work stealing
+//  each worker keeps its own deque of tasks, pushing and taking tasks it submits at the bottom, while idle
+//   workers steal from the top of deques of others, so that tasks spread over all workers with no shared
+//   queue to contend on. Tasks submitted from threads outside the pool go to a queue shared by all workers
+//  idle workers look for tasks a few rounds before parking, and are woken when tasks are submitted
+//  every task belongs to a task group, which may be waited for. Tasks submitted to the pool itself belong to
+//   a group of the pool. Threads waiting for a group run tasks meanwhile, therefore tasks may wait for groups
+//   of their own without starving the pool
+//  a pool is a RAII object, deleting it runs all tasks submitted before it stops its workers
+typedef struct ThreadPool ThreadPool;
+// group of tasks which are waited for together
+//  a task group is a RAII object, deleting it waits for its tasks first
+typedef struct TaskGroup TaskGroup;
+
+// placement of workers on processors
+enum ThreadPoolAffinity{
+    // workers run wherever the system schedules them
+    ThreadPoolAffinity_None,
+    // worker i is pinned to the i-th processor the creating thread may run on, wrapping around if there are
+    //  more workers, which is ignored on systems other than Linux
+    ThreadPoolAffinity_Compact,
+};
+// options of a thread pool, all zero for the defaults
+typedef struct{
+    // number of workers, 0 for one for each online processor
+    unsigned int workers;
+    enum ThreadPoolAffinity affinity;
+    // rounds of looking for tasks an idle worker makes before parking, 0 for ThreadPool_Spins
+    unsigned int spins;
+}ThreadPoolOptions;
+enum ThreadPool_Constant{
+    ThreadPool_Spins = 64,          // default rounds of looking for tasks before parking
+    ThreadPool_GrainDivisor = 8,    // default ranges of parallel_for per worker
+};
+
+// create a thread pool with options, NULL for the defaults
+//  return NULL if no worker can be started
+ThreadPool* ThreadPool_create(const ThreadPoolOptions* options);
+
+// get number of workers of pool
+unsigned int ThreadPool_workers(ThreadPool* pool);
+
+// run function with argument on a worker of pool, as a task of the group of pool
+void ThreadPool_submit(ThreadPool* pool, void (*function)(void* argument), void* argument);
+
+// wait until all tasks of the group of pool are done, including those they submit to the pool in turn
+void ThreadPool_wait(ThreadPool* pool);
+
+// call body on ranges splitting indexes from first to last exclusively, in parallel, and wait for all of them
+//  ranges are split in halves down to grain indexes, 0 for an even share of ThreadPool_GrainDivisor ranges per
+//   worker, so that idle workers steal large ranges and split them further themselves
+void ThreadPool_parallel_for(
+    ThreadPool* pool, size_t first, size_t last, size_t grain,
+    void (*body)(size_t begin, size_t end, void* context), void* context
+);
+
+// create a task group running its tasks on pool
+TaskGroup* TaskGroup_create(ThreadPool* pool);
+
+// run function with argument on a worker of the pool of group, as a task of group
+void TaskGroup_submit(TaskGroup* group, void (*function)(void* argument), void* argument);
+
+// wait until all tasks of group are done, including those submitted to group while waiting
+void TaskGroup_wait(TaskGroup* group);
+#endif
\ No newline at end of file
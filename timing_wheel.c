@@ -0,0 +1,190 @@
+#include "timing_wheel.h"
+#include "bitops.h"
+#include "list.h"
+#include "memory.h"
+#include "profile.h"
+#include "RAII.h"
+enum TimingWheel_Constant{
+    TimingWheel_SlotBits = 6,                           // bits of time resolved by each level
+    TimingWheel_Slots = 1 << TimingWheel_SlotBits,      // slots on each level
+    TimingWheel_Levels = (64 + TimingWheel_SlotBits - 1) / TimingWheel_SlotBits,   // levels to cover 64 bits
+};
+// timer in timing wheel, linked in the slot it belongs to
+//  the list node must be the first member, its data field holds the value
+struct TimingWheelTimer_{
+    ListNode link;
+    uint64_t expire;
+    List* slot;
+};
+struct TimingWheel{
+    RAII _;
+    List slots_[TimingWheel_Levels][TimingWheel_Slots];
+    // bit i of occupied_[n] is set if slot i on level n is not empty
+    uint64_t occupied_[TimingWheel_Levels];
+    uint64_t now_;
+    size_t size_;
+};
+
+// deleter for a timer which owns its value
+static void TimingWheelTimer_deleter_(void* target_){
+    RAII_delete(((ListNode*)target_)->data);
+}
+
+// get mask covering the times within a slot on specified level
+static inline uint64_t TimingWheel_slot_mask_(unsigned int level){
+    const unsigned int bits = level * TimingWheel_SlotBits;
+    return bits >= 64 ? UINT64_MAX : (UINT64_C(1) << bits) - 1;
+}
+
+// put a timer into the slot it belongs to with respect to current time
+static void TimingWheel_place_(TimingWheel* wheel, TimingWheelTimer* timer){
+    const uint64_t time = timer->expire < wheel->now_ ? wheel->now_ : timer->expire;
+    const uint64_t difference = time ^ wheel->now_;
+    const unsigned int level = difference == 0 ? 0 : (63 - BitOps_leading_zeros(difference)) / TimingWheel_SlotBits;
+    const unsigned int slot = (time >> (level * TimingWheel_SlotBits)) & (TimingWheel_Slots - 1);
+    timer->slot = &wheel->slots_[level][slot];
+    List_emplace_back(timer->slot, &timer->link);
+    wheel->occupied_[level] |= UINT64_C(1) << slot;
+}
+
+// take a timer out of its slot without destroying it
+static void TimingWheel_detach_(TimingWheel* wheel, TimingWheelTimer* timer){
+    List_detach(timer->slot, &timer->link);
+    if(List_empty(timer->slot)){
+        const size_t index = timer->slot - &wheel->slots_[0][0];
+        wheel->occupied_[index / TimingWheel_Slots] &= ~(UINT64_C(1) << (index % TimingWheel_Slots));
+    }
+}
+
+// cascade timers downwards until the earliest ones are on level 0, without advancing the current time past
+//  limit, which is the case if the earliest slot starts after limit
+//  return if there are timers on level 0 afterwards
+static bool TimingWheel_settle_(TimingWheel* wheel, uint64_t limit){
+    while(wheel->occupied_[0] == 0){
+        unsigned int level = 1;
+        while(level < TimingWheel_Levels && wheel->occupied_[level] == 0) level += 1;
+        if(level == TimingWheel_Levels) return false;
+        const unsigned int slot = BitOps_trailing_zeros(wheel->occupied_[level]);
+        const uint64_t start = (wheel->now_ & ~TimingWheel_slot_mask_(level + 1))
+                               | ((uint64_t)slot << (level * TimingWheel_SlotBits));
+        if(start > limit) return false;
+        // all timers in this slot share the higher bits with start, they go to lower levels
+        wheel->now_ = start;
+        List* bucket = &wheel->slots_[level][slot];
+        while(!List_empty(bucket)){
+            TimingWheelTimer* timer = (TimingWheelTimer*)bucket->head.next;
+            TimingWheel_detach_(wheel, timer);
+            TimingWheel_place_(wheel, timer);
+        }
+    }
+    return true;
+}
+
+// remove a timer and destroy it
+static void TimingWheel_erase_(TimingWheel* wheel, TimingWheelTimer* timer){
+    TimingWheel_detach_(wheel, timer);
+    RAII_delete(timer);
+    wheel->size_ -= 1;
+}
+
+// destroy the timing wheel
+static void TimingWheel_destroy_(TimingWheel* wheel){
+    TimingWheel_clear(wheel);
+}
+
+TimingWheel* TimingWheel_create(uint64_t now){
+    Profile_allocating_(ProfileKind_TimingWheel);
+    TimingWheel* wheel = (TimingWheel*)Memory_allocate_object(sizeof(TimingWheel));
+    for(unsigned int level = 0; level < TimingWheel_Levels; level++){
+        for(unsigned int slot = 0; slot < TimingWheel_Slots; slot++){
+            List_initialize(&wheel->slots_[level][slot]);
+        }
+        wheel->occupied_[level] = 0;
+    }
+    wheel->now_ = now;
+    wheel->size_ = 0;
+    RAII_set_deleter(wheel, (void(*)(void*))TimingWheel_destroy_);
+    return wheel;
+}
+
+void TimingWheel_clear(TimingWheel* wheel){
+    for(unsigned int level = 0; level < TimingWheel_Levels; level++){
+        // only visit slots in use
+        while(wheel->occupied_[level] != 0){
+            const unsigned int slot = BitOps_trailing_zeros(wheel->occupied_[level]);
+            List_clear(&wheel->slots_[level][slot]);
+            wheel->occupied_[level] &= ~(UINT64_C(1) << slot);
+        }
+    }
+    wheel->size_ = 0;
+}
+
+size_t TimingWheel_size(TimingWheel* wheel){
+    return wheel->size_;
+}
+
+uint64_t TimingWheel_now(TimingWheel* wheel){
+    return wheel->now_;
+}
+
+TimingWheelTimer* TimingWheel_schedule(TimingWheel* wheel, uint64_t expire, void* value, bool owns_value){
+    Profile_operation_(ProfileKind_TimingWheel);
+    Profile_allocating_(ProfileKind_TimingWheel);
+    TimingWheelTimer* timer = (TimingWheelTimer*)Memory_allocate_object(sizeof(TimingWheelTimer));
+    timer->link.data = value;
+    if(owns_value) RAII_set_deleter(timer, TimingWheelTimer_deleter_);
+    else RAII_set_dummy_deleter(timer);
+    timer->expire = expire;
+    TimingWheel_place_(wheel, timer);
+    wheel->size_ += 1;
+    return timer;
+}
+
+void TimingWheel_cancel(TimingWheel* wheel, TimingWheelTimer* timer){
+    Profile_operation_(ProfileKind_TimingWheel);
+    TimingWheel_erase_(wheel, timer);
+}
+
+bool TimingWheel_next(TimingWheel* wheel, uint64_t* expire){
+    Profile_operation_(ProfileKind_TimingWheel);
+    if(wheel->size_ == 0) return false;
+    if(wheel->occupied_[0] != 0){
+        // timers on level 0 expire exactly at the time of their slot, or at current time if overdue
+        const uint64_t time = (wheel->now_ & ~TimingWheel_slot_mask_(1))
+                              | BitOps_trailing_zeros(wheel->occupied_[0]);
+        if(time != wheel->now_){
+            *expire = time;
+            return true;
+        }
+    }
+    // the earliest timer is in the first slot of the lowest level in use, look through it
+    unsigned int level = 0;
+    while(wheel->occupied_[level] == 0) level += 1;
+    List* bucket = &wheel->slots_[level][BitOps_trailing_zeros(wheel->occupied_[level])];
+    *expire = UINT64_MAX;
+    for(ListNode* node = bucket->head.next; node != &bucket->head; node = node->next){
+        if(((TimingWheelTimer*)node)->expire < *expire) *expire = ((TimingWheelTimer*)node)->expire;
+    }
+    return true;
+}
+
+bool TimingWheel_pop_expired(TimingWheel* wheel, uint64_t now, uint64_t* expire, void** value){
+    Profile_operation_(ProfileKind_TimingWheel);
+    if(wheel->size_ == 0 || !TimingWheel_settle_(wheel, now)) return false;
+    const unsigned int slot = BitOps_trailing_zeros(wheel->occupied_[0]);
+    const uint64_t time = (wheel->now_ & ~TimingWheel_slot_mask_(1)) | slot;
+    if(time > now) return false;
+    wheel->now_ = time;
+    TimingWheelTimer* timer = (TimingWheelTimer*)wheel->slots_[0][slot].head.next;
+    if(expire != NULL) *expire = timer->expire;
+    if(value != NULL){
+        *value = timer->link.data;
+        RAII_set_dummy_deleter(timer);
+    }
+    TimingWheel_erase_(wheel, timer);
+    return true;
+}
+
+bool TimingWheel_pop_into(TimingWheel* wheel, uint64_t* expire, void** value){
+    return TimingWheel_pop_expired(wheel, UINT64_MAX, expire, value);
+}
\ No newline at end of file
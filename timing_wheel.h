@@ -0,0 +1,48 @@
+#ifndef CxKANOAXDP_timing_wheel_H_
+#define CxKANOAXDP_timing_wheel_H_
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+// hierarchical timing wheel scheduling timers on an integer clock of ticks
+//  each level has 64 slots, a slot on level n covers 64^n ticks. Timers are kept on the lowest level whose
+//  slot range separates them from the current time of the wheel and are cascaded downwards as the wheel
+//  advances, therefore scheduling, cancelling and expiring a timer all take amortized constant time
+//  the current time of the wheel only advances to expiration of timers popped from it, timers scheduled
+//  before the current time expire at it, in the order they are scheduled
+typedef struct TimingWheel TimingWheel;
+
+// handle to a timer in timing wheel, valid until the timer expires or is cancelled
+typedef struct TimingWheelTimer_ TimingWheelTimer;
+
+// create a new timing wheel whose current time is now
+TimingWheel* TimingWheel_create(uint64_t now);
+
+// remove all timers from timing wheel, keeping its current time
+void TimingWheel_clear(TimingWheel* wheel);
+
+// get number of timers in timing wheel
+inline size_t TimingWheel_size(TimingWheel* wheel);
+
+// get current time of timing wheel
+inline uint64_t TimingWheel_now(TimingWheel* wheel);
+
+// schedule a timer expiring at specified time carrying value
+//  the value is managed if owns_value is set, in which case it must be a RAII object
+//  return handle to the timer scheduled
+TimingWheelTimer* TimingWheel_schedule(TimingWheel* wheel, uint64_t expire, void* value, bool owns_value);
+
+// cancel a timer by its handle
+void TimingWheel_cancel(TimingWheel* wheel, TimingWheelTimer* timer);
+
+// get expiration of the earliest timer without advancing the wheel
+//  return false if there is no timer
+bool TimingWheel_next(TimingWheel* wheel, uint64_t* expire);
+
+// remove the earliest timer if it expires no later than now, handing its expiration and value to the caller
+//  ownership of the value is transferred to the caller if value is not NULL
+//  return if a timer was removed
+bool TimingWheel_pop_expired(TimingWheel* wheel, uint64_t now, uint64_t* expire, void** value);
+
+// remove the earliest timer regardless of its expiration, in the same way as TimingWheel_pop_expired
+bool TimingWheel_pop_into(TimingWheel* wheel, uint64_t* expire, void** value);
+#endif
\ No newline at end of file
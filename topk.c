@@ -0,0 +1,130 @@
+#include "topk.h"
+#include "RAII.h"
+#include "memory.h"
+#include "profile.h"
+struct TopK{
+    RAII _;
+    // elements kept, arranged as a heap with the element coming last in the order at top unless sorted
+    KeyValue* entries_;
+    size_t size_;
+    size_t capacity_;
+    // if entries are currently sorted instead of arranged as a heap
+    bool sorted_;
+    int (*compare_)(const void* lhs_, const void* rhs_);
+};
+
+// swap two elements
+static inline void TopK_swap_(TopK* top_k, size_t p, size_t q){
+    KeyValue temp = top_k->entries_[p];
+    top_k->entries_[p] = top_k->entries_[q];
+    top_k->entries_[q] = temp;
+}
+
+// adjust the element at specified position upwards
+static void TopK_swim_(TopK* top_k, size_t current_index){
+    while(current_index != 0){
+        size_t parent_index = ((current_index + 1) >> 1) - 1;
+        if(top_k->compare_(top_k->entries_[current_index].key, top_k->entries_[parent_index].key) > 0){
+            TopK_swap_(top_k, parent_index, current_index);
+            current_index = parent_index;
+        }else{
+            break;
+        }
+    }
+}
+
+// adjust the element at specified position downwards, considering only the first size elements
+static void TopK_sink_(TopK* top_k, size_t current_index, size_t size){
+    while(((current_index + 1) << 1) - 1 < size){
+        size_t right_child_index = (current_index + 1) << 1;
+        size_t left_child_index = right_child_index - 1;
+        size_t compare_target_index = left_child_index;
+        if(right_child_index < size && top_k->compare_(
+            top_k->entries_[left_child_index].key, top_k->entries_[right_child_index].key
+        ) < 0){
+            compare_target_index = right_child_index;
+        }
+        if(top_k->compare_(top_k->entries_[current_index].key, top_k->entries_[compare_target_index].key) < 0){
+            TopK_swap_(top_k, compare_target_index, current_index);
+            current_index = compare_target_index;
+        }else{
+            break;
+        }
+    }
+}
+
+// arrange sorted elements as a heap again
+//  sorted elements reversed form a valid heap already
+static void TopK_unsort_(TopK* top_k){
+    if(!top_k->sorted_) return;
+    for(size_t i = 0, j = top_k->size_; i + 1 < j; i++, j--) TopK_swap_(top_k, i, j - 1);
+    top_k->sorted_ = false;
+}
+
+// destroy the collection
+static void TopK_destroy_(TopK* top_k){
+    TopK_clear(top_k);
+    Memory_release(top_k->entries_);
+}
+
+TopK* TopK_create(int (*compare)(const void* lhs_, const void* rhs_), size_t capacity){
+    Profile_allocating_(ProfileKind_TopK);
+    TopK* top_k = (TopK*)Memory_allocate_object(sizeof(TopK));
+    Profile_allocating_(ProfileKind_TopK);
+    top_k->entries_ = (KeyValue*)Memory_allocate(sizeof(KeyValue) * (capacity == 0 ? 1 : capacity));
+    top_k->size_ = 0;
+    top_k->capacity_ = capacity;
+    top_k->sorted_ = false;
+    top_k->compare_ = compare;
+    RAII_set_deleter(top_k, (void(*)(void*))TopK_destroy_);
+    return top_k;
+}
+
+void TopK_clear(TopK* top_k){
+    for(size_t i = 0; i < top_k->size_; i++) RAII_destroy(top_k->entries_ + i);
+    top_k->size_ = 0;
+    top_k->sorted_ = false;
+}
+
+size_t TopK_size(TopK* top_k){
+    return top_k->size_;
+}
+
+bool TopK_offer(TopK* top_k, void* key, bool owns_key, void* value, bool owns_value){
+    Profile_operation_(ProfileKind_TopK);
+    if(top_k->size_ < top_k->capacity_){
+        TopK_unsort_(top_k);
+        KeyValue_initialize(top_k->entries_ + top_k->size_, key, owns_key, value, owns_value);
+        top_k->size_ += 1;
+        TopK_swim_(top_k, top_k->size_ - 1);
+        return true;
+    }
+    if(top_k->capacity_ == 0 || top_k->compare_(key, TopK_threshold(top_k)) >= 0){
+        if(owns_key) RAII_delete(key);
+        if(owns_value) RAII_delete(value);
+        return false;
+    }
+    TopK_unsort_(top_k);
+    RAII_destroy(top_k->entries_);
+    KeyValue_initialize(top_k->entries_, key, owns_key, value, owns_value);
+    TopK_sink_(top_k, 0, top_k->size_);
+    return true;
+}
+
+void* TopK_threshold(TopK* top_k){
+    if(top_k->size_ < top_k->capacity_ || top_k->size_ == 0) return NULL;
+    // the element to be displaced is at top, or at the end if sorted
+    return top_k->entries_[top_k->sorted_ ? top_k->size_ - 1 : 0].key;
+}
+
+KeyValue* TopK_sort(TopK* top_k){
+    Profile_operation_(ProfileKind_TopK);
+    if(!top_k->sorted_){
+        for(size_t end = top_k->size_; end > 1; end--){
+            TopK_swap_(top_k, 0, end - 1);
+            TopK_sink_(top_k, 0, end - 1);
+        }
+        top_k->sorted_ = true;
+    }
+    return top_k->entries_;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef CxKANOAXDP_topk_H_
+#define CxKANOAXDP_topk_H_
+#include "keyvalue_pair.h"
+#include <stdbool.h>
+#include <stddef.h>
+// bounded collection keeping the first few elements offered to it in the order specified when creating it,
+//  that is, the elements a Heap with the same order would pop first
+//  elements are kept in a fixed array arranged as a heap with the last kept element at top, so a candidate
+//  is rejected with a single comparison and an accepted one replaces the top in place, with no allocation
+typedef struct TopK TopK;
+
+// create a new top-k collection keeping no more than capacity elements
+//  compare specifies the order by which the elements are arranged
+TopK* TopK_create(int (*compare)(const void* lhs_, const void* rhs_), size_t capacity);
+
+// remove all elements from collection
+void TopK_clear(TopK* top_k);
+
+// get number of elements kept
+inline size_t TopK_size(TopK* top_k);
+
+// offer a candidate element to collection
+//  ownership of key and value is specified in the same way as Heap_insert. Managed key and value of a
+//   candidate rejected or an element displaced later are deallocated
+//  return if the candidate is kept
+bool TopK_offer(TopK* top_k, void* key, bool owns_key, void* value, bool owns_value);
+
+// get key of the element to be displaced by the next candidate accepted
+//  return NULL if the collection is not yet full, in which case any candidate will be accepted
+void* TopK_threshold(TopK* top_k);
+
+// sort elements kept in collection, the first element comes first in the order
+//  return array of TopK_size elements, which is valid until the collection is modified
+KeyValue* TopK_sort(TopK* top_k);
+#endif
\ No newline at end of file
@@ -0,0 +1,168 @@
+#ifndef CxKANOAXDP_typed_hashmap_H_
+#define CxKANOAXDP_typed_hashmap_H_
+#include "RAII.h"
+#include "memory.h"
+#include "profile.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+// generator of hash maps storing keys and values of specified types by value, with every function inline
+//  BASE_DEFINE_HASHMAP(name, K, V, hash, eq) defines type name and functions name_create, name_find and so on,
+//   shaped after those of FlatHashTable. hash(key) is a function or macro giving a 64-bit hash of a key, and
+//   eq(lhs, rhs) tells if two keys are equal, both taking keys by value
+//  the map uses open addressing with linear probing, and removes entries by shifting later ones of the same
+//   run back, so no tombstone is left. Hashes are spread over lines by Fibonacci hashing, so integer keys
+//   may be hashed by identity
+//  keys and values are copied in as plain values and are not managed
+//  a map is a RAII object, created maps are deleted with RAII_delete, initialized ones destroyed with
+//   RAII_destroy
+enum TypedHashMap_Constant{
+    TypedHashMap_MinCapacity = 16,  // capacity allocated for the first entry
+    TypedHashMap_MaxLoad = 3,       // most entries per TypedHashMap_LoadBase slots before growing
+    TypedHashMap_LoadBase = 4,
+};
+#define TypedHashMap_Fibonacci_ 0x9E3779B97F4A7C15ull
+
+#define BASE_DEFINE_HASHMAP(name, K, V, hash, eq)                                                           \
+typedef struct{                                                                                             \
+    K key;                                                                                                  \
+    V value;                                                                                                \
+}name##Entry;                                                                                               \
+typedef struct{                                                                                             \
+    RAII _;                                                                                                 \
+    name##Entry* entries_;                                                                                  \
+    /* which slots hold entries, stored after entries in the same block */                                  \
+    unsigned char* used_;                                                                                   \
+    size_t capacity_;                                                                                       \
+    size_t size_;                                                                                           \
+    /* 64 less log2 of capacity, by which hashes are shifted to get home slots */                           \
+    unsigned int shift_;                                                                                    \
+}name;                                                                                                      \
+                                                                                                            \
+static inline void name##_destroy_(void* target_){                                                          \
+    name* map = (name*)target_;                                                                             \
+    Memory_release(map->entries_);                                                                          \
+    map->entries_ = NULL;                                                                                   \
+    map->used_ = NULL;                                                                                      \
+    map->capacity_ = map->size_ = 0;                                                                        \
+}                                                                                                           \
+                                                                                                            \
+/* get the slot a key belongs to, capacity must not be 0 */                                                 \
+static inline size_t name##_home_(const name* map, K key){                                                  \
+    return (size_t)(((uint64_t)(hash(key)) * TypedHashMap_Fibonacci_) >> map->shift_);                      \
+}                                                                                                           \
+                                                                                                            \
+/* get the slot holding key, or capacity if not found */                                                    \
+static inline size_t name##_slot_(const name* map, K key){                                                  \
+    if(map->size_ == 0) return map->capacity_;                                                              \
+    const size_t mask = map->capacity_ - 1;                                                                 \
+    for(size_t slot = name##_home_(map, key); map->used_[slot]; slot = (slot + 1) & mask){                  \
+        if(eq(map->entries_[slot].key, key)) return slot;                                                   \
+    }                                                                                                       \
+    return map->capacity_;                                                                                  \
+}                                                                                                           \
+                                                                                                            \
+/* put an entry known to be absent into a map known to have room, return its slot */                        \
+static inline size_t name##_put_(name* map, K key, V value){                                                \
+    const size_t mask = map->capacity_ - 1;                                                                 \
+    size_t slot = name##_home_(map, key);                                                                   \
+    while(map->used_[slot]) slot = (slot + 1) & mask;                                                       \
+    map->entries_[slot] = (name##Entry){.key = key, .value = value};                                        \
+    map->used_[slot] = 1;                                                                                   \
+    map->size_ += 1;                                                                                        \
+    return slot;                                                                                            \
+}                                                                                                           \
+                                                                                                            \
+/* move all entries to a new block of specified capacity, which is a power of 2 */                          \
+static inline void name##_rehash_(name* map, size_t capacity){                                              \
+    name##Entry* entries = map->entries_;                                                                   \
+    unsigned char* used = map->used_;                                                                       \
+    const size_t previous_capacity = map->capacity_;                                                        \
+    Profile_allocating_(ProfileKind_FlatHashTable);                                                         \
+    map->entries_ = (name##Entry*)Memory_allocate((sizeof(name##Entry) + 1) * capacity);                    \
+    map->used_ = (unsigned char*)(map->entries_ + capacity);                                                \
+    memset(map->used_, 0, capacity);                                                                        \
+    map->capacity_ = capacity;                                                                              \
+    map->size_ = 0;                                                                                         \
+    map->shift_ = 64;                                                                                       \
+    for(size_t lines = capacity; lines > 1; lines >>= 1) map->shift_ -= 1;                                  \
+    for(size_t i = 0; i < previous_capacity; i++){                                                          \
+        if(used[i]) name##_put_(map, entries[i].key, entries[i].value);                                     \
+    }                                                                                                       \
+    Memory_release(entries);                                                                                \
+}                                                                                                           \
+                                                                                                            \
+/* initialize an empty map embedded elsewhere */                                                            \
+static inline void name##_initialize(name* map){                                                            \
+    map->entries_ = NULL;                                                                                   \
+    map->used_ = NULL;                                                                                      \
+    map->capacity_ = map->size_ = 0;                                                                        \
+    map->shift_ = 64;                                                                                       \
+    RAII_set_deleter(map, name##_destroy_);                                                                 \
+}                                                                                                           \
+                                                                                                            \
+static inline name* name##_create(void){                                                                    \
+    Profile_allocating_(ProfileKind_FlatHashTable);                                                         \
+    name* map = (name*)Memory_allocate_object(sizeof(name));                                                \
+    name##_initialize(map);                                                                                 \
+    return map;                                                                                             \
+}                                                                                                           \
+                                                                                                            \
+/* remove all entries, keeping the space allocated */                                                       \
+static inline void name##_clear(name* map){                                                                 \
+    if(map->capacity_ != 0) memset(map->used_, 0, map->capacity_);                                          \
+    map->size_ = 0;                                                                                         \
+}                                                                                                           \
+                                                                                                            \
+static inline size_t name##_size(const name* map){                                                          \
+    return map->size_;                                                                                      \
+}                                                                                                           \
+                                                                                                            \
+/* make room for at least count entries without growing again */                                            \
+static inline void name##_reserve(name* map, size_t count){                                                 \
+    size_t capacity = map->capacity_ == 0 ? TypedHashMap_MinCapacity : map->capacity_;                      \
+    while(count * TypedHashMap_LoadBase > capacity * TypedHashMap_MaxLoad) capacity <<= 1;                  \
+    if(capacity != map->capacity_) name##_rehash_(map, capacity);                                           \
+}                                                                                                           \
+                                                                                                            \
+/* get pointer to value stored with key, which is valid until next insertion, or NULL if not found */        \
+static inline V* name##_find(name* map, K key){                                                             \
+    Profile_operation_(ProfileKind_FlatHashTable);                                                          \
+    const size_t slot = name##_slot_(map, key);                                                             \
+    return slot == map->capacity_ ? NULL : &map->entries_[slot].value;                                      \
+}                                                                                                           \
+                                                                                                            \
+/* insert an entry if no entry with same key exists                                                         \
+    result receives pointer to the value stored with key if not NULL, return if the entry is inserted */    \
+static inline bool name##_insert(name* map, K key, V value, V** result){                                    \
+    Profile_operation_(ProfileKind_FlatHashTable);                                                          \
+    size_t slot = name##_slot_(map, key);                                                                   \
+    const bool absent = slot == map->capacity_;                                                             \
+    if(absent){                                                                                             \
+        name##_reserve(map, map->size_ + 1);                                                                \
+        slot = name##_put_(map, key, value);                                                                \
+    }                                                                                                       \
+    if(result != NULL) *result = &map->entries_[slot].value;                                                \
+    return absent;                                                                                          \
+}                                                                                                           \
+                                                                                                            \
+/* remove the entry with specified key, return if an entry is removed */                                    \
+static inline bool name##_erase(name* map, K key){                                                          \
+    Profile_operation_(ProfileKind_FlatHashTable);                                                          \
+    size_t hole = name##_slot_(map, key);                                                                   \
+    if(hole == map->capacity_) return false;                                                                \
+    const size_t mask = map->capacity_ - 1;                                                                 \
+    /* shift back later entries of the run which would no longer be found past the hole */                  \
+    for(size_t next = (hole + 1) & mask; map->used_[next]; next = (next + 1) & mask){                       \
+        const size_t home = name##_home_(map, map->entries_[next].key);                                     \
+        if(((next - home) & mask) >= ((next - hole) & mask)){                                               \
+            map->entries_[hole] = map->entries_[next];                                                      \
+            hole = next;                                                                                    \
+        }                                                                                                   \
+    }                                                                                                       \
+    map->used_[hole] = 0;                                                                                   \
+    map->size_ -= 1;                                                                                        \
+    return true;                                                                                            \
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,137 @@
+#ifndef CxKANOAXDP_typed_heap_H_
+#define CxKANOAXDP_typed_heap_H_
+#include "RAII.h"
+#include "memory.h"
+#include "profile.h"
+#include <stdbool.h>
+#include <stddef.h>
+// generator of binary heaps storing elements of a specified type by value, with every function inline
+//  BASE_DEFINE_HEAP(name, T, less) defines type name and functions name_create, name_insert and so on, shaped
+//   after those of Heap. less(lhs, rhs) is a function or macro taking two elements by value, which tells if
+//   lhs goes before rhs; the top of heap is the element no other goes before
+//  elements are copied in and out as plain values and are not managed, therefore no handle to them is given
+//   and they cannot be updated or erased in place
+//  a heap is a RAII object, created heaps are deleted with RAII_delete, initialized ones destroyed with
+//   RAII_destroy
+enum TypedHeap_Constant{
+    TypedHeap_InitialCapability = 32,   // capability allocated for the first element
+};
+
+#define BASE_DEFINE_HEAP(name, T, less)                                                                     \
+typedef struct{                                                                                             \
+    RAII _;                                                                                                 \
+    T* data;                                                                                                \
+    size_t size;                                                                                            \
+    size_t capability;                                                                                      \
+}name;                                                                                                      \
+                                                                                                            \
+static inline void name##_destroy_(void* target_){                                                          \
+    name* heap = (name*)target_;                                                                            \
+    Memory_release(heap->data);                                                                             \
+    heap->data = NULL;                                                                                      \
+    heap->size = heap->capability = 0;                                                                      \
+}                                                                                                           \
+                                                                                                            \
+/* make room for at least capability elements */                                                            \
+static inline void name##_reserve_(name* heap, size_t capability){                                          \
+    if(capability <= heap->capability) return;                                                              \
+    if(capability < heap->capability << 1) capability = heap->capability << 1;                              \
+    if(capability < TypedHeap_InitialCapability) capability = TypedHeap_InitialCapability;                  \
+    Profile_allocating_(ProfileKind_Heap);                                                                  \
+    heap->data = (T*)Memory_reallocate(heap->data, sizeof(T) * capability);                                 \
+    heap->capability = capability;                                                                          \
+}                                                                                                           \
+                                                                                                            \
+/* move the element at index up until its parent goes before it, carrying it rather than swapping */        \
+static inline void name##_sift_up_(name* heap, size_t index){                                               \
+    T element = heap->data[index];                                                                          \
+    while(index > 0){                                                                                       \
+        const size_t parent = (index - 1) >> 1;                                                             \
+        if(!(less(element, heap->data[parent]))) break;                                                     \
+        heap->data[index] = heap->data[parent];                                                             \
+        index = parent;                                                                                     \
+    }                                                                                                       \
+    heap->data[index] = element;                                                                            \
+}                                                                                                           \
+                                                                                                            \
+/* move the element at index down until it goes before its children */                                      \
+static inline void name##_sift_down_(name* heap, size_t index){                                             \
+    T element = heap->data[index];                                                                          \
+    while(true){                                                                                            \
+        size_t child = (index << 1) + 1;                                                                    \
+        if(child >= heap->size) break;                                                                      \
+        if(child + 1 < heap->size && less(heap->data[child + 1], heap->data[child])) child += 1;            \
+        if(!(less(heap->data[child], element))) break;                                                      \
+        heap->data[index] = heap->data[child];                                                              \
+        index = child;                                                                                      \
+    }                                                                                                       \
+    heap->data[index] = element;                                                                            \
+}                                                                                                           \
+                                                                                                            \
+/* initialize an empty heap embedded elsewhere */                                                           \
+static inline void name##_initialize(name* heap){                                                           \
+    heap->data = NULL;                                                                                      \
+    heap->size = heap->capability = 0;                                                                      \
+    RAII_set_deleter(heap, name##_destroy_);                                                                \
+}                                                                                                           \
+                                                                                                            \
+static inline name* name##_create(void){                                                                    \
+    Profile_allocating_(ProfileKind_Heap);                                                                  \
+    name* heap = (name*)Memory_allocate_object(sizeof(name));                                               \
+    name##_initialize(heap);                                                                                \
+    return heap;                                                                                            \
+}                                                                                                           \
+                                                                                                            \
+static inline void name##_clear(name* heap){                                                                \
+    heap->size = 0;                                                                                         \
+}                                                                                                           \
+                                                                                                            \
+static inline size_t name##_size(const name* heap){                                                         \
+    return heap->size;                                                                                      \
+}                                                                                                           \
+                                                                                                            \
+static inline bool name##_empty(const name* heap){                                                          \
+    return heap->size == 0;                                                                                 \
+}                                                                                                           \
+                                                                                                            \
+static inline void name##_insert(name* heap, T element){                                                    \
+    Profile_operation_(ProfileKind_Heap);                                                                   \
+    name##_reserve_(heap, heap->size + 1);                                                                  \
+    heap->data[heap->size] = element;                                                                       \
+    heap->size += 1;                                                                                        \
+    name##_sift_up_(heap, heap->size - 1);                                                                  \
+}                                                                                                           \
+                                                                                                            \
+/* insert count elements at once, which takes linear time with respect to the size of heap */               \
+static inline void name##_build(name* heap, const T* elements, size_t count){                               \
+    Profile_operation_(ProfileKind_Heap);                                                                   \
+    name##_reserve_(heap, heap->size + count);                                                              \
+    for(size_t i = 0; i < count; i++) heap->data[heap->size + i] = elements[i];                             \
+    heap->size += count;                                                                                    \
+    for(size_t i = heap->size >> 1; i > 0; i--) name##_sift_down_(heap, i - 1);                             \
+}                                                                                                           \
+                                                                                                            \
+/* get pointer to the top element, which is valid until heap changes, NULL if empty */                      \
+static inline T* name##_top(name* heap){                                                                    \
+    Profile_operation_(ProfileKind_Heap);                                                                   \
+    return heap->size == 0 ? NULL : heap->data;                                                             \
+}                                                                                                           \
+                                                                                                            \
+/* remove the top element, ignored if empty */                                                              \
+static inline void name##_pop(name* heap){                                                                  \
+    Profile_operation_(ProfileKind_Heap);                                                                   \
+    if(heap->size == 0) return;                                                                             \
+    heap->size -= 1;                                                                                        \
+    if(heap->size == 0) return;                                                                             \
+    heap->data[0] = heap->data[heap->size];                                                                 \
+    name##_sift_down_(heap, 0);                                                                             \
+}                                                                                                           \
+                                                                                                            \
+/* remove the top element, copying it into element, return false if empty */                                \
+static inline bool name##_pop_into(name* heap, T* element){                                                 \
+    if(heap->size == 0) return false;                                                                       \
+    *element = heap->data[0];                                                                               \
+    name##_pop(heap);                                                                                       \
+    return true;                                                                                            \
+}
+#endif
\ No newline at end of file
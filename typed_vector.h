@@ -0,0 +1,93 @@
+#ifndef CxKANOAXDP_typed_vector_H_
+#define CxKANOAXDP_typed_vector_H_
+#include "RAII.h"
+#include "memory.h"
+#include "profile.h"
+#include <stdbool.h>
+#include <stddef.h>
+// generator of vectors storing elements of a specified type by value, with every function inline
+//  BASE_DEFINE_VECTOR(name, T) defines type name and functions name_create, name_at and so on, shaped after
+//   those of Vector. Elements are copied in and out as plain values and are not managed
+//  nothing is allocated until the first element is put, and clearing keeps the space allocated
+//  a vector is a RAII object, created vectors are deleted with RAII_delete, initialized ones destroyed with
+//   RAII_destroy
+enum TypedVector_Constant{
+    TypedVector_EnlargeBias = 10,   // bias of enlarging the capability, the same as Vector
+};
+
+#define BASE_DEFINE_VECTOR(name, T)                                                                         \
+typedef struct{                                                                                             \
+    RAII _;                                                                                                 \
+    T* data;                                                                                                \
+    size_t size;                                                                                            \
+    size_t capability;                                                                                      \
+}name;                                                                                                      \
+                                                                                                            \
+static inline void name##_destroy_(void* target_){                                                          \
+    name* vector = (name*)target_;                                                                          \
+    Memory_release(vector->data);                                                                           \
+    vector->data = NULL;                                                                                    \
+    vector->size = vector->capability = 0;                                                                  \
+}                                                                                                           \
+                                                                                                            \
+/* initialize an empty vector embedded elsewhere */                                                         \
+static inline void name##_initialize(name* vector){                                                         \
+    vector->data = NULL;                                                                                    \
+    vector->size = vector->capability = 0;                                                                  \
+    RAII_set_deleter(vector, name##_destroy_);                                                              \
+}                                                                                                           \
+                                                                                                            \
+static inline name* name##_create(void){                                                                    \
+    Profile_allocating_(ProfileKind_Vector);                                                                \
+    name* vector = (name*)Memory_allocate_object(sizeof(name));                                             \
+    name##_initialize(vector);                                                                              \
+    return vector;                                                                                          \
+}                                                                                                           \
+                                                                                                            \
+static inline void name##_clear(name* vector){                                                              \
+    vector->size = 0;                                                                                       \
+}                                                                                                           \
+                                                                                                            \
+static inline size_t name##_size(const name* vector){                                                       \
+    return vector->size;                                                                                    \
+}                                                                                                           \
+                                                                                                            \
+static inline bool name##_empty(const name* vector){                                                        \
+    return vector->size == 0;                                                                               \
+}                                                                                                           \
+                                                                                                            \
+/* change capability, ignored if it is less than size */                                                    \
+static inline void name##_recap(name* vector, size_t new_capability){                                       \
+    if(new_capability == vector->capability || new_capability < vector->size) return;                       \
+    Profile_allocating_(ProfileKind_Vector);                                                                \
+    vector->data = (T*)Memory_reallocate(vector->data, sizeof(T) * new_capability);                         \
+    vector->capability = new_capability;                                                                    \
+}                                                                                                           \
+                                                                                                            \
+static inline void name##_emplace_back(name* vector, T element){                                            \
+    Profile_operation_(ProfileKind_Vector);                                                                 \
+    if(vector->size == vector->capability){                                                                 \
+        name##_recap(vector, (vector->capability << 1) + TypedVector_EnlargeBias);                          \
+    }                                                                                                       \
+    vector->data[vector->size++] = element;                                                                 \
+}                                                                                                           \
+                                                                                                            \
+/* remove the last element, ignored if empty */                                                             \
+static inline void name##_pop_back(name* vector){                                                           \
+    Profile_operation_(ProfileKind_Vector);                                                                 \
+    if(vector->size != 0) vector->size -= 1;                                                                \
+}                                                                                                           \
+                                                                                                            \
+static inline void name##_swap(name* vector, size_t p, size_t q){                                           \
+    Profile_operation_(ProfileKind_Vector);                                                                 \
+    T temporary = vector->data[p];                                                                          \
+    vector->data[p] = vector->data[q];                                                                      \
+    vector->data[q] = temporary;                                                                            \
+}                                                                                                           \
+                                                                                                            \
+/* get pointer to element at index, which is valid until capability changes, NULL if out of range */        \
+static inline T* name##_at(name* vector, size_t index){                                                     \
+    Profile_operation_(ProfileKind_Vector);                                                                 \
+    return index < vector->size ? vector->data + index : NULL;                                              \
+}
+#endif
\ No newline at end of file
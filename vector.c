@@ -1,5 +1,9 @@
 #include "RAII.h"
+#include "memory.h"
+#include "profile.h"
+#include "reclaimer.h"
 #include "vector.h"
+#include <string.h>
 enum Constant{
     VectorInitialCapability = 32,   // initial capability of vector
     VectorEnlargeBias = 10,         // bias of enlarging the vector capability
@@ -12,7 +16,8 @@ static void VectorItem_deleter_(void* target_){
     RAII_delete(((VectorItem_*)target_)->data);
 }
 static VectorItem_* VectorItem_create_(void* data, bool owned){
-    VectorItem_* item = (VectorItem_*)malloc(sizeof(VectorItem_));
+    Profile_allocating_(ProfileKind_Vector);
+    VectorItem_* item = (VectorItem_*)Memory_allocate_object(sizeof(VectorItem_));
     item->data = data;
     if(owned) RAII_set_deleter(item, VectorItem_deleter_);
     else RAII_set_dummy_deleter(item);
@@ -27,20 +32,22 @@ struct Vector{
 // destroy a vector
 static void Vector_destroy_(Vector* vector){
     Vector_clear(vector);
-    free(vector->data);
+    Memory_release(vector->data);
     vector->data = NULL;
     vector->size = 0;
     vector->capability = 0;
 }
 // initialize vector
 static inline void Vector_initialize_(Vector* vector){
-    vector->data = (VectorItem_**)malloc(sizeof(VectorItem_*) * VectorInitialCapability);
+    Profile_allocating_(ProfileKind_Vector);
+    vector->data = (VectorItem_**)Memory_allocate(sizeof(VectorItem_*) * VectorInitialCapability);
     vector->size = 0;
     vector->capability = VectorInitialCapability;
     RAII_set_deleter(vector, (void(*)(void*))Vector_destroy_);
 }
 Vector* Vector_create(){
-    Vector* vector = (Vector*)malloc(sizeof(Vector));
+    Profile_allocating_(ProfileKind_Vector);
+    Vector* vector = (Vector*)Memory_allocate_object(sizeof(Vector));
     Vector_initialize_(vector);
     return vector;
 }
@@ -49,16 +56,33 @@ void Vector_clear(Vector* vector){
         RAII_delete(vector->data[i]);
     }
     if(vector->capability >= VectorInitialCapability){
-        vector->data = (VectorItem_**)realloc(vector->data, sizeof(VectorItem_*) * VectorInitialCapability);
+        Profile_allocating_(ProfileKind_Vector);
+        vector->data = (VectorItem_**)Memory_reallocate(
+            vector->data, sizeof(VectorItem_*) * VectorInitialCapability
+        );
     }else{
         // avoid unwanted copy of memory content
-        free(vector->data);
-        vector->data = (VectorItem_**)malloc(sizeof(VectorItem_*) * VectorInitialCapability);
+        Memory_release(vector->data);
+        Profile_allocating_(ProfileKind_Vector);
+        vector->data = (VectorItem_**)Memory_allocate(sizeof(VectorItem_*) * VectorInitialCapability);
     }
     vector->size = 0;
     vector->capability = VectorInitialCapability;
 }
 
+void Vector_clear_deferred(Vector* vector){
+    if(vector->size == 0) return;
+    // the array moves to a vector of its own, and a new one is allocated in its place
+    Profile_allocating_(ProfileKind_Vector);
+    Vector* detached = (Vector*)Memory_allocate_object(sizeof(Vector));
+    detached->data = vector->data;
+    detached->size = vector->size;
+    detached->capability = vector->capability;
+    RAII_set_deleter(detached, (void(*)(void*))Vector_destroy_);
+    Vector_initialize_(vector);
+    Reclaimer_defer(detached);
+}
+
 size_t Vector_size(Vector* vector){
     return vector->size;
 }
@@ -69,11 +93,13 @@ bool Vector_empty(Vector* vector){
 
 void Vector_recap(Vector* vector, size_t new_capability){
     if(new_capability == vector->capability || new_capability < vector->size) return;
-    vector->data = (VectorItem_**)realloc(vector->data, sizeof(VectorItem_*) * new_capability);
+    Profile_allocating_(ProfileKind_Vector);
+    vector->data = (VectorItem_**)Memory_reallocate(vector->data, sizeof(VectorItem_*) * new_capability);
     vector->capability = new_capability;
 }
 
 void Vector_emplace_back(Vector* vector, void* data, bool owned){
+    Profile_operation_(ProfileKind_Vector);
     if(vector->size == vector->capability){
         Vector_recap(vector, (vector->capability << 1) + VectorEnlargeBias);
     }
@@ -82,7 +108,19 @@ void Vector_emplace_back(Vector* vector, void* data, bool owned){
     vector->size += 1;
 }
 
+void Vector_splice_back(Vector* vector, Vector* source){
+    if(vector->size + source->size > vector->capability){
+        Vector_recap(vector, vector->size + source->size);
+    }
+    memcpy(vector->data + vector->size, source->data, sizeof(VectorItem_*) * source->size);
+    vector->size += source->size;
+    // items are now referenced by vector, reset source without destroying them
+    source->size = 0;
+    Vector_clear(source);
+}
+
 void Vector_pop_back(Vector* vector){
+    Profile_operation_(ProfileKind_Vector);
     if(vector->size == 0) return;
     vector->size -= 1;
     RAII_delete(vector->data[vector->size]);
@@ -90,6 +128,7 @@ void Vector_pop_back(Vector* vector){
 }
 
 void Vector_swap(Vector* vector, size_t p, size_t q){
+    Profile_operation_(ProfileKind_Vector);
     if(p >= vector->size || q >= vector->size) return;
     VectorItem_* temp = vector->data[p];
     vector->data[p] = vector->data[q];
@@ -97,6 +136,7 @@ void Vector_swap(Vector* vector, size_t p, size_t q){
 }
 
 void* Vector_at(Vector* vector, size_t index){
+    Profile_operation_(ProfileKind_Vector);
     if(index >= vector->size) return NULL;
     return vector->data[index]->data;
 }
@@ -12,6 +12,9 @@ Vector* Vector_create();
 // clear elements in vector
 void Vector_clear(Vector* vector);
 
+// clear elements in vector in constant time, handing them over to the reclaimer thread to be deleted
+void Vector_clear_deferred(Vector* vector);
+
 // get number of elements in vector
 inline size_t Vector_size(Vector* vector);
 
@@ -24,6 +27,10 @@ void Vector_recap(Vector* vector, size_t new_capability);
 // emplace a element at the end of vector
 void Vector_emplace_back(Vector* vector, void* data, bool owned);
 
+// move all elements from source to the end of vector, leaving source empty
+//  ownership of the elements moves along with them
+void Vector_splice_back(Vector* vector, Vector* source);
+
 // remove the last element from vector
 void Vector_pop_back(Vector* vector);
 